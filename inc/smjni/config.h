@@ -39,4 +39,25 @@
     #define SMJNI_NO_INLINE [[gnu::noinline]]
 #endif
 
+//TLS model for the library's per-thread fast paths. Initial-exec makes access a single
+//thread pointer relative load but is not supported in dlopen-ed libraries on older Android
+#ifndef SMJNI_TLS_MODEL
+    #if (defined(__GNUC__) || defined(__clang__)) && !defined(__ANDROID__)
+        #define SMJNI_TLS_MODEL [[gnu::tls_model("initial-exec")]]
+    #else
+        #define SMJNI_TLS_MODEL
+    #endif
+#endif
+
+//Whether @CriticalNative methods are registered with their implementation directly. Only ART on
+//Android 8.0+ calls such methods without JNIEnv and jclass, other VMs (and older Android versions
+//which ignore the annotation) get an adapter with the standard signature
+#ifndef SMJNI_DIRECT_CRITICAL_NATIVES
+    #if defined(__ANDROID__) && defined(__ANDROID_API__) && __ANDROID_API__ >= 26
+        #define SMJNI_DIRECT_CRITICAL_NATIVES 1
+    #else
+        #define SMJNI_DIRECT_CRITICAL_NATIVES 0
+    #endif
+#endif
+
 #endif
\ No newline at end of file
@@ -20,6 +20,7 @@
 
 #include <utility>
 #include <cassert>
+#include <cstddef>
 #include <type_traits>
 
 namespace smjni
@@ -135,6 +136,34 @@ namespace smjni
         {
             return string_array<N, string_own_impl>(s, tr);
         }
+
+        struct char_replacer
+        {
+            char from;
+            char to;
+
+            constexpr char operator()(char c) const
+                { return c != from ? c : to; }
+        };
+
+        template<int N, template<int> class Impl>
+        constexpr string_array<N, string_own_impl> replace(const string_array<N, Impl> & s, char from, char to)
+        {
+            return transform(s, char_replacer{from, to});
+        }
+
+        template<int N, template<int> class Impl, std::size_t M>
+        constexpr bool operator==(const string_array<N, Impl> & s, const char (&literal)[M])
+        {
+            if (std::size_t(N) + 1 != M)
+                return false;
+            for (int i = 0; i < N; ++i)
+            {
+                if (s[i] != literal[i])
+                    return false;
+            }
+            return true;
+        }
     }
 }
 
@@ -0,0 +1,62 @@
+/*
+ Copyright 2019 SmJNI Contributors
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#ifndef HEADER_GLOBAL_REF_POOL_H_INCLUDED
+#define HEADER_GLOBAL_REF_POOL_H_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+
+#include <smjni/jni_provider.h>
+
+namespace smjni
+{
+    //Bookkeeping for global references created and deleted through global_java_ref
+    //
+    //This only counts references. JNI offers no way to re-point an existing global reference,
+    //so slots cannot be recycled, and every DeleteGlobalRef takes the VM's global handle lock
+    //no matter when or in what batches it is called, so deferring deletions cannot reduce
+    //lock acquisitions either. Deletion therefore always happens immediately.
+    class global_ref_pool
+    {
+    public:
+        struct statistics
+        {
+            //global references currently alive
+            size_t live;
+            size_t created;
+            size_t deleted;
+        };
+    public:
+        global_ref_pool() = delete;
+
+        static statistics get_statistics() noexcept;
+
+        static void on_created() noexcept
+            { s_created.fetch_add(1, std::memory_order_relaxed); }
+
+        static void release(jobject obj)
+        {
+            jni_provider::get_jni()->DeleteGlobalRef(obj);
+            s_deleted.fetch_add(1, std::memory_order_relaxed);
+        }
+    private:
+        static std::atomic<size_t> s_created;
+        static std::atomic<size_t> s_deleted;
+    };
+}
+
+#endif //HEADER_GLOBAL_REF_POOL_H_INCLUDED
@@ -18,6 +18,8 @@
 #ifndef HEADER_JAVA_ARRAY_H_INCLUDED
 #define HEADER_JAVA_ARRAY_H_INCLUDED
 
+#include <stdexcept>
+
 #include <smjni/jni_provider.h>
 #include <smjni/java_ref.h>
 
@@ -0,0 +1,273 @@
+/*
+ Copyright 2019 SmJNI Contributors
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#ifndef HEADER_JAVA_CALL_STATS_H_INCLUDED
+#define HEADER_JAVA_CALL_STATS_H_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    #include <intrin.h>
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    #include <x86intrin.h>
+#else
+    #include <chrono>
+#endif
+
+#include <smjni/config.h>
+#include <smjni/java_type_traits.h>
+
+//Latency instrumentation of Java calls made through java_method, java_static_method,
+//java_constructor, java_field and java_static_field. Off unless explicitly enabled
+//in which case it still has to be switched on at runtime via java_call_stats::set_enabled.
+//Define it through the SMJNI_INSTRUMENT_CALLS CMake option, never per consumer, since it changes class layouts
+#ifndef SMJNI_INSTRUMENT_CALLS
+    #define SMJNI_INSTRUMENT_CALLS 0
+#endif
+
+namespace smjni
+{
+    namespace internal
+    {
+        //Raw timestamp counter. Ticks are converted to nanoseconds only when a snapshot is taken
+        SMJNI_FORCE_INLINE uint64_t call_clock_ticks() noexcept
+        {
+        #if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+            return __rdtsc();
+        #elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+            return __rdtsc();
+        #elif (defined(__GNUC__) || defined(__clang__)) && defined(__aarch64__)
+            uint64_t ret;
+            asm volatile("mrs %0, cntvct_el0" : "=r"(ret));
+            return ret;
+        #else
+            return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                std::chrono::steady_clock::now().time_since_epoch()).count());
+        #endif
+        }
+
+        //Call counts and an HDR-style log-linear latency histogram for one Java method or field.
+        //Values below 2^sub_bucket_bits ticks are recorded exactly, larger ones in 2^sub_bucket_bits
+        //linear sub-buckets per power of two which bounds the relative error at 1/2^sub_bucket_bits
+        class java_call_site
+        {
+        public:
+            static constexpr unsigned sub_bucket_bits = 3;
+            static constexpr unsigned sub_bucket_count = 1u << sub_bucket_bits;
+            //powers of two above that are clamped into the last bucket
+            static constexpr unsigned max_magnitude = 47;
+            static constexpr unsigned bucket_count = sub_bucket_count * (max_magnitude - sub_bucket_bits + 2);
+        public:
+            java_call_site(const char * kind, const char * class_name, std::string name, const char * signature):
+                m_kind(kind),
+                m_class_name(class_name),
+                m_name(std::move(name)),
+                m_signature(signature)
+            {}
+
+            java_call_site(const java_call_site &) = delete;
+            java_call_site & operator=(const java_call_site &) = delete;
+
+            void record(uint64_t ticks) noexcept
+            {
+                m_buckets[bucket_of(ticks)].fetch_add(1, std::memory_order_relaxed);
+                m_total.fetch_add(ticks, std::memory_order_relaxed);
+                if (ticks > m_max.load(std::memory_order_relaxed))
+                    update_max(ticks);
+            }
+
+            static constexpr unsigned bucket_of(uint64_t ticks) noexcept
+            {
+                if (ticks < sub_bucket_count)
+                    return unsigned(ticks);
+                unsigned magnitude = 63 - count_leading_zeros(ticks);
+                if (magnitude > max_magnitude)
+                    return bucket_count - 1;
+                unsigned sub = unsigned(ticks >> (magnitude - sub_bucket_bits)) & (sub_bucket_count - 1);
+                return sub_bucket_count * (magnitude - sub_bucket_bits + 1) + sub;
+            }
+
+            //Smallest value that lands in the given bucket
+            static constexpr uint64_t bucket_low(unsigned bucket) noexcept
+            {
+                if (bucket < sub_bucket_count)
+                    return bucket;
+                unsigned magnitude = bucket / sub_bucket_count + sub_bucket_bits - 1;
+                uint64_t sub = bucket % sub_bucket_count;
+                return (uint64_t(1) << magnitude) | (sub << (magnitude - sub_bucket_bits));
+            }
+
+            const char * kind() const noexcept
+                { return m_kind; }
+            const char * class_name() const noexcept
+                { return m_class_name; }
+            const std::string & name() const noexcept
+                { return m_name; }
+            const char * signature() const noexcept
+                { return m_signature; }
+
+            uint64_t count(unsigned bucket) const noexcept
+                { return m_buckets[bucket].load(std::memory_order_relaxed); }
+            uint64_t total() const noexcept
+                { return m_total.load(std::memory_order_relaxed); }
+            uint64_t max() const noexcept
+                { return m_max.load(std::memory_order_relaxed); }
+
+            void reset() noexcept;
+        private:
+            static constexpr unsigned count_leading_zeros(uint64_t val) noexcept
+            {
+                unsigned ret = 0;
+                for (uint64_t mask = uint64_t(1) << 63; !(val & mask); mask >>= 1)
+                    ++ret;
+                return ret;
+            }
+
+            void update_max(uint64_t ticks) noexcept
+            {
+                uint64_t current = m_max.load(std::memory_order_relaxed);
+                while (ticks > current && !m_max.compare_exchange_weak(current, ticks, std::memory_order_relaxed))
+                {}
+            }
+        private:
+            const char * const m_kind;
+            const char * const m_class_name;
+            const std::string m_name;
+            const char * const m_signature;
+            std::atomic<uint64_t> m_buckets[bucket_count] = {};
+            std::atomic<uint64_t> m_total{0};
+            std::atomic<uint64_t> m_max{0};
+        };
+
+        //Returns the site for the given kind, class, name and signature creating it if necessary.
+        //Sites are never destroyed. kind, class_name and signature must be string literals or otherwise immortal
+        java_call_site * register_call_site(const char * kind, const char * class_name, const char * name, const char * signature);
+
+        //Java class name of T if known. Array types have none
+        template<typename T, typename = void>
+        struct java_call_site_class
+        {
+            static constexpr const char * get() noexcept
+                { return ""; }
+        };
+
+        template<typename T>
+        struct java_call_site_class<T, std::void_t<decltype(java_type_traits<T>::class_name())>>
+        {
+            static constexpr const char * get() noexcept
+                { return java_type_traits<T>::class_name(); }
+        };
+    }
+
+    //Global switch and reporting for Java call instrumentation
+    class java_call_stats
+    {
+    public:
+        java_call_stats() = delete;
+
+        static constexpr bool compiled_in = SMJNI_INSTRUMENT_CALLS != 0;
+
+        static void set_enabled(bool value) noexcept
+            { s_enabled.store(value, std::memory_order_relaxed); }
+        static bool enabled() noexcept
+            { return s_enabled.load(std::memory_order_relaxed); }
+
+        //Returns all sites that recorded at least one call as a JSON object of the form
+        //{"methods":[{"kind":..., "class":..., "name":..., "signature":..., "count":..., "total_ns":..., "mean_ns":...,
+        //             "p50_ns":..., "p90_ns":..., "p99_ns":..., "p999_ns":..., "max_ns":...,
+        //             "histogram":[[low_ns, count], ...]}, ...]}
+        static std::string snapshot_json();
+
+        //Clears recorded data of all sites. Concurrent calls may be partially recorded
+        static void reset();
+    private:
+        static std::atomic<bool> s_enabled;
+    };
+
+    namespace internal
+    {
+    #if SMJNI_INSTRUMENT_CALLS
+
+        template<size_t Count>
+        class java_call_sites
+        {
+        public:
+            java_call_sites() noexcept = default;
+
+            template<typename... Kind>
+            java_call_sites(const char * class_name, const char * name, const char * signature, Kind... kind):
+                m_sites{register_call_site(kind, class_name, name, signature)...}
+            {}
+
+            java_call_site * site(size_t idx) const noexcept
+                { return m_sites[idx]; }
+        private:
+            java_call_site * m_sites[Count] = {};
+        };
+
+        class java_call_timer
+        {
+        public:
+            SMJNI_FORCE_INLINE java_call_timer(java_call_site * site) noexcept:
+                m_site(site && java_call_stats::enabled() ? site : nullptr),
+                m_start(m_site ? call_clock_ticks() : 0)
+            {}
+            SMJNI_FORCE_INLINE ~java_call_timer() noexcept
+            {
+                if (m_site)
+                    m_site->record(call_clock_ticks() - m_start);
+            }
+
+            java_call_timer(const java_call_timer &) = delete;
+            java_call_timer & operator=(const java_call_timer &) = delete;
+        private:
+            java_call_site * const m_site;
+            const uint64_t m_start;
+        };
+
+    #else
+
+        //Empty placeholders so that instrumented classes pay nothing, not even storage (via EBO)
+        template<size_t Count>
+        class java_call_sites
+        {
+        public:
+            java_call_sites() noexcept = default;
+
+            template<typename... Kind>
+            java_call_sites(const char *, const char *, const char *, Kind...) noexcept
+            {}
+
+            constexpr std::nullptr_t site(size_t) const noexcept
+                { return nullptr; }
+        };
+
+        class java_call_timer
+        {
+        public:
+            constexpr java_call_timer(std::nullptr_t) noexcept
+            {}
+        };
+
+    #endif
+    }
+}
+
+#endif //HEADER_JAVA_CALL_STATS_H_INCLUDED
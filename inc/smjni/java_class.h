@@ -18,9 +18,8 @@
 #ifndef HEADER_JAVA_CLASS_H_INCLUDED
 #define	HEADER_JAVA_CLASS_H_INCLUDED
 
-#include <memory>
-#include <mutex>
-#include <functional>
+#include <atomic>
+#include <type_traits>
 
 #include <smjni/java_ref.h>
 #include <smjni/java_type_traits.h>
@@ -30,41 +29,47 @@ namespace smjni
 {
     namespace internal
     {
+        //Signatures are constant initialized so using them never involves a static initialization guard
         template<typename T>
-        const char * java_field_signature()
+        inline constexpr auto java_field_signature_v = java_type_traits<T>::signature();
+
+        template<typename ReturnType, typename... ArgType>
+        inline constexpr auto java_method_signature_v = (make_string_array("(") + ... + java_type_traits<ArgType>::signature()) + 
+                                                        make_string_array(")") + java_type_traits<ReturnType>::signature();
+
+        template<typename T>
+        constexpr const char * java_field_signature() noexcept
         {
-            using internal::string_array;
-            static constexpr const auto sig = java_type_traits<T>::signature();
-            return sig.c_str();
+            return java_field_signature_v<T>.c_str();
         }
     
         template<typename ReturnType, typename... ArgType>
-        const char * java_method_signature()
+        constexpr const char * java_method_signature() noexcept
         {
-            using internal::string_array;
-            static constexpr const auto sig = (make_string_array("(") + ... + java_type_traits<ArgType>::signature()) + make_string_array(")") + java_type_traits<ReturnType>::signature();
-            return sig.c_str();
+            return java_method_signature_v<ReturnType, ArgType...>.c_str();
         }
-    
-        class java_class_holder
+
+        //@CriticalNative methods may only take and return primitives
+        template<typename T>
+        inline constexpr bool is_critical_native_type_v = std::is_arithmetic_v<T> || std::is_void_v<T>;
+
+        template<auto Func>
+        struct critical_native;
+
+        template<typename ReturnType, typename... ArgType, ReturnType (JNICALL *Func)(ArgType...)>
+        struct critical_native<Func>
         {
-        public:
-            java_class_holder(global_java_ref<jclass> && clazz):
-                m_class(std::move(clazz))
-            {}
-                
-            jclass c_ptr() const
-            {
-                return m_class.c_ptr();
-            }
+            static_assert(is_critical_native_type_v<ReturnType> && (is_critical_native_type_v<ArgType> && ...),
+                          "critical native methods can only use primitive types");
 
-            bool is_instance_of(JNIEnv * jenv, const auto_java_ref<jobject> & obj) const
-            {
-                return jenv->IsInstanceOf(obj.c_ptr(), c_ptr());
-            }
-            
-        private:
-            global_java_ref<jclass> m_class;
+            typedef ReturnType return_type;
+
+            static constexpr const char * signature() noexcept
+                { return java_method_signature<ReturnType, ArgType...>(); }
+
+            //Standard entry point for VMs that do not support critical natives
+            static ReturnType JNICALL adapter(JNIEnv *, jclass, ArgType... args)
+                { return Func(args...); }
         };
     }
 
@@ -80,23 +85,30 @@ namespace smjni
                                           std::is_invocable_r_v<global_java_ref<jclass>, Callable, JNIEnv *>;
     public:
         java_class(const auto_java_ref<jclass> & clazz):
-            m_holder(init([clazz] () { return clazz; }))
+            m_class(init([clazz] () { return clazz; }))
         {}
         
         template<class Loader>
         java_class(JNIEnv * jenv, Loader loader,
                    std::enable_if_t<is_loader<Loader>> * = nullptr):
-            m_holder(init([loader, jenv] () { return loader(jenv); }))
+            m_class(init([loader, jenv] () { return loader(jenv); }))
         {}
         
-        jclass c_ptr() const
+        jclass c_ptr() const noexcept
         {
-            return m_holder->c_ptr();
+            return m_class;
         }
-        
+
+        //The class reference shared by all java_class<T> objects or null if none was constructed yet.
+        //Stays valid once published so it can be used without holding a java_class<T>
+        static jclass published() noexcept
+        {
+            return s_class.load(std::memory_order_acquire);
+        }
+
         bool is_instance_of(JNIEnv * jenv, const auto_java_ref<jobject> & obj) const
         {
-            return m_holder->is_instance_of(jenv, obj);
+            return jenv->IsInstanceOf(obj.c_ptr(), m_class);
         }
 
         template<typename ReturnType, typename... ArgType>
@@ -121,6 +133,23 @@ namespace smjni
             return {name_type(name), signature_type(signature), (method_type)func};
         }
 
+        //Binds a static @CriticalNative method implemented without JNIEnv and jclass parameters,
+        //e.g. bind_native<hash>("hash"). See SMJNI_DIRECT_CRITICAL_NATIVES
+        template<auto Func>
+        static JNINativeMethod bind_native(const char * name) noexcept
+        {
+            using name_type = decltype(JNINativeMethod::name);
+            using signature_type = decltype(JNINativeMethod::signature);
+            using method_type = decltype(JNINativeMethod::fnPtr);
+
+            typedef internal::critical_native<Func> native;
+        #if SMJNI_DIRECT_CRITICAL_NATIVES
+            return {name_type(name), signature_type(native::signature()), (method_type)Func};
+        #else
+            return {name_type(name), signature_type(native::signature()), (method_type)&native::adapter};
+        #endif
+        }
+
         template<size_t N>
         void register_natives(JNIEnv * jenv, const JNINativeMethod (&methods)[N]) const
         {
@@ -133,30 +162,29 @@ namespace smjni
         }
         
     private:
+        //The global class reference is shared by all java_class<T> objects and published once for
+        //the lifetime of the process. If several threads race to load it only one reference is kept.
         template<class Loader>
         static
-        std::shared_ptr<internal::java_class_holder> init(Loader loader)
+        jclass init(Loader loader)
         {
-            std::lock_guard<std::mutex> lock(s_holder_mutex);
-            auto ret = s_holder.lock();
-            if (!ret)
-            {
-                ret = std::make_shared<internal::java_class_holder>(loader());
-                s_holder = ret;
-            }
+            jclass ret = s_class.load(std::memory_order_acquire);
+            if (ret)
+                return ret;
+            
+            global_java_ref<jclass> loaded = loader();
+            if (s_class.compare_exchange_strong(ret, loaded.c_ptr(), std::memory_order_acq_rel, std::memory_order_acquire))
+                return loaded.release();
             return ret;
         }
         
     private:
-        const std::shared_ptr<internal::java_class_holder> m_holder;
+        jclass m_class;
         
-        static std::mutex s_holder_mutex;
-        static std::weak_ptr<internal::java_class_holder> s_holder;
+        static std::atomic<jclass> s_class;
     };
     template<typename T>
-    std::mutex java_class<T>::s_holder_mutex;
-    template<typename T>
-    std::weak_ptr<internal::java_class_holder> java_class<T>::s_holder;
+    std::atomic<jclass> java_class<T>::s_class{nullptr};
 }
 
 #endif	//HEADER_JAVA_CLASS_H_INCLUDED
@@ -20,22 +20,71 @@
 
 #include <smjni/config.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include <smjni/jni_provider.h>
+#include <smjni/java_class.h>
+
 namespace smjni
 {
+    enum class java_class_table_mode
+    {
+        //construct all classes in init() on the calling thread
+        eager,
+        //construct classes on first get<T>(). Classes that register native methods are still
+        //constructed in init() since Java code may call them before C++ ever asks for the class,
+        //unless register_all_natives has already registered them. So are classes with inline
+        //accessors since their free functions never go through get<T>().
+        lazy,
+        //construct all classes in init() on the calling thread plus a number of attached worker threads.
+        //Worker threads are attached natively so FindClass on them uses the system class loader.
+        //Do not use this mode if your classes are only visible to the application class loader (e.g. on Android)
+        parallel
+    };
+
+    struct java_class_init_timing
+    {
+        const char * name;
+        std::chrono::nanoseconds duration;
+        bool constructed;
+    };
+
+    namespace internal
+    {
+        template<typename T>
+        T java_type_of_class(const java_class<T> *);
+
+        //Set by register_all_natives for classes whose native methods it has registered
+        template<typename Class>
+        inline std::atomic<bool> java_natives_registered_v{false};
+
+        template<typename T, typename Enable = void>
+        struct java_class_name_of
+        {
+            static const char * get() noexcept
+                { return ""; }
+        };
+
+        template<typename T>
+        struct java_class_name_of<T, std::void_t<decltype(java_type_traits<decltype(java_type_of_class((const T *)nullptr))>::class_name())>>
+        {
+            static const char * get() noexcept
+                { return java_type_traits<decltype(java_type_of_class((const T *)nullptr))>::class_name(); }
+        };
+    }
+
     template<typename... Classes>
     class java_class_table
     {
     private:
-        template<typename... T>
-        static JNIEnv * tuple_forward(JNIEnv * env)
-            { return env; }
-        
-        template <typename Func, typename... T>
-        static void tuple_for_each(std::tuple<T...> &ts, Func func) 
-        {
-            int unused[] = {(func(std::get<T>(ts)),0)...};
-            (void)unused;
-        }
+        static constexpr size_t class_count = sizeof...(Classes);
         
         template <template<typename> class Transform, typename... T>
         struct tuple_transform
@@ -43,65 +92,200 @@ namespace smjni
             typedef std::tuple<Transform<T>...> type;
         };
         
-        class registrator
-        {
-        public:
-            registrator(JNIEnv * env):
-                m_env(env)
-            {}
+        template <typename T> static std::true_type can_register_helper( decltype(&T::register_methods) );
+        template <typename T> static std::false_type can_register_helper(...);
+        
+        template<typename T>
+        static constexpr bool can_register = decltype(can_register_helper<T>(nullptr))::value;
+        
+        template <typename T> static std::bool_constant<T::inline_accessors> has_inline_accessors_helper(decltype(&T::inline_accessors));
+        template <typename T> static std::false_type has_inline_accessors_helper(...);
+        
+        template<typename T>
+        static constexpr bool has_inline_accessors = decltype(has_inline_accessors_helper<T>(nullptr))::value;
 
-            template<typename X>
-            void operator()(const X & cls) const
+        template<typename T>
+        static constexpr size_t index_of()
+        {
+            constexpr bool matches[] = {false, std::is_same_v<T, Classes>...};
+            for (size_t i = 1; i <= class_count; ++i)
             {
-                if constexpr (can_register<X>)
-                {
-                    cls.register_methods(m_env);
-                }
+                if (matches[i])
+                    return i - 1;
             }
-
-        private:
-            template <typename T> static std::true_type can_register_helper( decltype(&T::register_methods) );
-            template <typename T> static std::false_type can_register_helper(...);
-            
-            template<typename T>
-            static constexpr bool can_register = decltype(can_register_helper<T>(nullptr))::value;
-
-            JNIEnv * const m_env;
-        };
+            return class_count;
+        }
         
-        struct table : public std::tuple<Classes...>
+        typedef void (*constructor)(JNIEnv *);
+    public:
+        static void init(JNIEnv * env, java_class_table_mode mode = java_class_table_mode::eager, unsigned thread_count = 0)
         {
-            table(JNIEnv * env):
-                std::tuple<Classes...>(tuple_forward<Classes>(env)...)
+            s_instance = new java_class_table;
+            try
             {
-                tuple_for_each(*this, registrator(env));
+                switch(mode)
+                {
+                case java_class_table_mode::eager:
+                    (ensure_constructed<Classes>(env), ...);
+                    break;
+                case java_class_table_mode::lazy:
+                    (ensure_required<Classes>(env), ...);
+                    break;
+                case java_class_table_mode::parallel:
+                    init_parallel(env, thread_count);
+                    break;
+                }
+            }
+            catch(...)
+            {
+                term();
+                throw;
             }
-        };
-    public:
-        static void init(JNIEnv * env)
-        {
-            s_instance = new java_class_table(env);
         }
         static void term()
         {
             delete s_instance;
+            s_instance = nullptr;
         }
 
         template<typename T>
         static const T & get()
         {
-            return std::get<T>(s_instance->m_table);
+            T * ret = std::get<std::atomic<T *>>(s_instance->m_classes).load(std::memory_order_acquire);
+            if (!ret)
+                ret = construct<T>(jni_provider::get_jni());
+            return *ret;
+        }
+        
+        //Time it took to construct (look up and register) each class so far
+        static std::vector<java_class_init_timing> init_timings()
+        {
+            std::vector<java_class_init_timing> ret;
+            ret.reserve(class_count);
+            (ret.push_back(init_timing<Classes>()), ...);
+            return ret;
         }
         
         template <template<typename> class Transform>
         using transformed_type = typename tuple_transform<Transform, Classes...>::type;
     private:
-        java_class_table(JNIEnv * env):
-            m_table(env)
+        java_class_table() = default;
+        ~java_class_table()
+        {
+            (delete std::get<std::atomic<Classes *>>(m_classes).load(std::memory_order_acquire), ...);
+        }
+        
+        template<typename T>
+        static void ensure_constructed(JNIEnv * env)
+        {
+            if (!std::get<std::atomic<T *>>(s_instance->m_classes).load(std::memory_order_acquire))
+                construct<T>(env);
+        }
+        
+        //Constructs the classes that lazy mode cannot defer
+        template<typename T>
+        static void ensure_required(JNIEnv * env)
+        {
+            if constexpr (has_inline_accessors<T>)
+            {
+                ensure_constructed<T>(env);
+            }
+            else if constexpr (can_register<T>)
+            {
+                if (!internal::java_natives_registered_v<T>.load(std::memory_order_acquire))
+                    ensure_constructed<T>(env);
+            }
+        }
+        
+        //Lock-free: concurrent first callers may each construct an instance but only one is published
+        template<typename T>
+        SMJNI_NO_INLINE static T * construct(JNIEnv * env)
+        {
+            auto start = std::chrono::steady_clock::now();
+            auto created = std::make_unique<T>(env);
+            if constexpr (can_register<T>)
+            {
+                if (!internal::java_natives_registered_v<T>.load(std::memory_order_acquire))
+                    created->register_methods(env);
+            }
+            auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+            
+            T * expected = nullptr;
+            if (!std::get<std::atomic<T *>>(s_instance->m_classes).compare_exchange_strong(expected, created.get(),
+                                                                                            std::memory_order_acq_rel,
+                                                                                            std::memory_order_acquire))
+            {
+                return expected;
+            }
+            s_instance->m_durations[index_of<T>()].store(duration.count(), std::memory_order_relaxed);
+            return created.release();
+        }
+        
+        static void init_parallel(JNIEnv * env, unsigned thread_count)
+        {
+            static constexpr constructor constructors[] = { &java_class_table::ensure_constructed<Classes>... };
+            
+            if (thread_count == 0)
+                thread_count = std::max(1u, std::thread::hardware_concurrency());
+            if (thread_count > class_count)
+                thread_count = unsigned(class_count);
+            
+            std::atomic<size_t> next(0);
+            std::vector<std::exception_ptr> errors(thread_count);
+            auto worker = [&next, &errors] (JNIEnv * worker_env, unsigned index) {
+                try
+                {
+                    for(size_t i = next.fetch_add(1); i < class_count; i = next.fetch_add(1))
+                        constructors[i](worker_env);
+                }
+                catch(...)
+                {
+                    errors[index] = std::current_exception();
+                    next.store(class_count);
+                }
+            };
+            
+            std::vector<std::thread> threads;
+            threads.reserve(thread_count);
+            for (unsigned i = 1; i < thread_count; ++i)
+            {
+                threads.emplace_back([&worker, i] () {
+                    JNIEnv * worker_env;
+                    try
+                    {
+                        worker_env = jni_provider::get_jni();
+                    }
+                    catch(...)
+                    {
+                        //let the remaining threads do the work
+                        return;
+                    }
+                    worker(worker_env, i);
+                });
+            }
+            worker(env, 0);
+            for (auto & thread: threads)
+                thread.join();
+            
+            for (auto & error: errors)
+            {
+                if (error)
+                    std::rethrow_exception(error);
+            }
+        }
+        
+        template<typename T>
+        static java_class_init_timing init_timing()
         {
+            java_class_init_timing ret;
+            ret.name = internal::java_class_name_of<T>::get();
+            ret.constructed = s_instance && std::get<std::atomic<T *>>(s_instance->m_classes).load(std::memory_order_acquire);
+            ret.duration = std::chrono::nanoseconds(s_instance ? s_instance->m_durations[index_of<T>()].load(std::memory_order_relaxed) : 0);
+            return ret;
         }
     private:
-        table m_table;
+        std::tuple<std::atomic<Classes *>...> m_classes{};
+        std::atomic<std::chrono::nanoseconds::rep> m_durations[class_count] = {};
         
         static java_class_table * s_instance;
     };
@@ -0,0 +1,145 @@
+/*
+ Copyright 2019 SmJNI Contributors
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#ifndef HEADER_JAVA_EVENT_BATCHER_H_INCLUDED
+#define HEADER_JAVA_EVENT_BATCHER_H_INCLUDED
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <smjni/java_ref.h>
+#include <smjni/java_type_traits.h>
+#include <smjni/java_direct_buffer.h>
+
+namespace smjni
+{
+    struct java_event_batcher_policy
+    {
+        //events per batch, a full batch is delivered immediately
+        size_t batch_size = 1024;
+        //batches in the ring, producers block only when all of them are waiting for delivery
+        size_t batch_count = 4;
+        //longest time an event may wait in a partially filled batch
+        std::chrono::milliseconds max_delay{10};
+    };
+
+    namespace internal
+    {
+        //Type erased machinery behind java_event_batcher
+        class event_batch_queue
+        {
+        public:
+            typedef void (*deliver_func)(void * context, JNIEnv * env, const auto_java_ref<jByteBuffer> & buffer, jint count);
+
+        private:
+            struct batch
+            {
+                std::unique_ptr<unsigned char[]> data;
+                global_java_ref<jByteBuffer> buffer;
+                size_t count = 0;
+            };
+        public:
+            event_batch_queue(size_t record_size, const java_event_batcher_policy & policy,
+                              deliver_func deliver, void * context, const char * thread_name);
+            ~event_batch_queue() noexcept;
+
+            event_batch_queue(const event_batch_queue &) = delete;
+            event_batch_queue & operator=(const event_batch_queue &) = delete;
+
+            void push(const void * record);
+            void flush();
+
+        private:
+            void run(std::string name, std::promise<void> & started) noexcept;
+            void deliver_next(JNIEnv * env, std::unique_lock<std::mutex> & lock) noexcept;
+
+        private:
+            const size_t m_record_size;
+            const java_event_batcher_policy m_policy;
+            const deliver_func m_deliver;
+            void * const m_context;
+
+            std::vector<batch> m_batches;
+
+            std::mutex m_mutex;
+            std::condition_variable m_work;
+            std::condition_variable m_progress;
+            //m_sealed batches starting at m_next_delivery wait for delivery, the one after them is being filled
+            size_t m_next_delivery = 0;
+            size_t m_sealed = 0;
+            std::chrono::steady_clock::time_point m_deadline;
+            unsigned long long m_pushed = 0;
+            unsigned long long m_delivered = 0;
+            unsigned long long m_flush_target = 0;
+            bool m_stopping = false;
+
+            std::thread m_thread;
+        };
+    }
+
+    //Accumulates native events and hands them to Java in batches so that a burst of events
+    //costs one upcall per batch rather than one per event.
+    //
+    //Events are copied verbatim into direct ByteBuffers that are allocated once and reused.
+    //A dedicated thread, attached to the VM as thread_name, invokes
+    //sink(JNIEnv *, const auto_java_ref<jByteBuffer> & buffer, jint count) with the first count
+    //events of the buffer. The buffer is only valid during the call so Java code must consume
+    //it before returning and should read it using ByteOrder.nativeOrder().
+    //
+    //push() and flush() may be called from any thread but not from the sink.
+    template<typename Event, typename Sink>
+    class java_event_batcher
+    {
+        static_assert(std::is_trivially_copyable_v<Event>, "events are copied to Java as raw bytes");
+    public:
+        java_event_batcher(Sink sink, const java_event_batcher_policy & policy = java_event_batcher_policy(),
+                           const char * thread_name = "smjni-event-batcher"):
+            m_sink(std::move(sink)),
+            m_queue(sizeof(Event), policy, &java_event_batcher::deliver, this, thread_name)
+        {}
+
+        void push(const Event & event)
+            { m_queue.push(&event); }
+
+        //Delivers every event pushed so far and waits for the sink to process them
+        void flush()
+            { m_queue.flush(); }
+    private:
+        static void deliver(void * context, JNIEnv * env, const auto_java_ref<jByteBuffer> & buffer, jint count)
+            { static_cast<java_event_batcher *>(context)->m_sink(env, buffer, count); }
+    private:
+        Sink m_sink;
+        //declared last so that the delivery thread stops before the sink is destroyed
+        internal::event_batch_queue m_queue;
+    };
+
+    template<typename Event, typename Sink>
+    java_event_batcher<Event, Sink> make_java_event_batcher(Sink sink,
+                                                            const java_event_batcher_policy & policy = java_event_batcher_policy())
+    {
+        return java_event_batcher<Event, Sink>(std::move(sink), policy);
+    }
+}
+
+#endif //HEADER_JAVA_EVENT_BATCHER_H_INCLUDED
@@ -18,20 +18,35 @@
 #ifndef HEADER_JAVA_EXCEPTION_H_INCLUDED
 #define HEADER_JAVA_EXCEPTION_H_INCLUDED
 
+#include <atomic>
 #include <string>
 
 #include <smjni/java_ref.h>
+#include <smjni/native_backtrace.h>
 
 namespace smjni
 {
+    class java_exception_dispatcher;
 
-    class java_exception final : public std::exception
+    //Throw from native code that detects it is about to exhaust its stack, e.g. a recursion depth guard.
+    //java_exception::translate raises the preallocated StackOverflowError for it.
+    class native_stack_overflow : public std::exception
     {
+    public:
+        const char * what() const noexcept override
+            { return "native stack overflow"; }
+    };
+
+    //Can be derived from to give specific Java exceptions their own C++ type. See java_exception_dispatcher.
+    class java_exception : public std::exception
+    {
+    friend java_exception_dispatcher;
     public:
         java_exception(const auto_java_ref<jthrowable> & ex) noexcept :
-            m_throwable(ex)
+            m_throwable(ex),
+            m_backtrace(native_backtrace::capture_shared())
         {
-            
+            m_what[0] = 0;
         }
         
         const char * what() const noexcept override;
@@ -39,6 +54,10 @@ namespace smjni
         jthrowable throwable() const noexcept
             { return m_throwable.c_ptr(); }
         
+        //Native stack at the point the exception was created, null unless native_backtrace is enabled
+        const native_backtrace * backtrace() const noexcept
+            { return m_backtrace.get(); }
+        
         void raise(JNIEnv * jenv) const
         {
             raise(jenv, m_throwable.c_ptr());
@@ -50,7 +69,7 @@ namespace smjni
             if (ex)
             {
                 jenv->ExceptionClear();
-                throw java_exception(ex);
+                throw_pending(jenv, ex);
             }
         }
         
@@ -64,11 +83,21 @@ namespace smjni
         static void translate(JNIEnv * env, const std::exception & ex);
         
     protected:
-        std::string do_what() const;
+        void do_what() const;
+    private:
+        SMJNI_NO_INLINE [[noreturn]] static void throw_pending(JNIEnv * jenv, jthrowable ex);
+        static void attach_backtrace(JNIEnv * jenv, const native_backtrace & backtrace) noexcept;
         
     private:
+        //Longer descriptions are truncated. Keeping the buffer inline means neither
+        //what() nor copying the exception ever allocates.
+        static constexpr size_t s_what_capacity = 256;
+        
         global_java_ref<jthrowable> m_throwable;
-        mutable std::string m_what;
+        std::shared_ptr<const native_backtrace> m_backtrace;
+        mutable char m_what[s_what_capacity];
+        
+        static inline std::atomic<const java_exception_dispatcher *> s_dispatcher{nullptr};
     };
     
     
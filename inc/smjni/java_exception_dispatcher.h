@@ -0,0 +1,87 @@
+/*
+ Copyright 2019 SmJNI Contributors
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#ifndef HEADER_JAVA_EXCEPTION_DISPATCHER_H_INCLUDED
+#define HEADER_JAVA_EXCEPTION_DISPATCHER_H_INCLUDED
+
+#include <type_traits>
+#include <vector>
+
+#include <smjni/java_exception.h>
+#include <smjni/java_class.h>
+
+namespace smjni
+{
+    //Throws Java exceptions as C++ subclasses of java_exception chosen by the Java exception class
+    //
+    //When several registered classes match, the most derived one wins. Handlers are kept ordered
+    //most derived first as they are added so raising costs one IsInstanceOf per handler up to the
+    //first match and nothing else. JNI provides no stable class identity that could key a cache
+    //cheaper than that.
+    //
+    //Register everything before installing the dispatcher. add() is not thread safe.
+    class java_exception_dispatcher
+    {
+    private:
+        typedef void (*thrower)(jthrowable);
+    public:
+        //Installs a dispatcher for the lifetime of the scope and then restores the previous one
+        class scoped_install
+        {
+        public:
+            scoped_install(const java_exception_dispatcher & dispatcher) noexcept:
+                m_previous(install(&dispatcher))
+            {}
+            ~scoped_install() noexcept
+                { install(m_previous); }
+            scoped_install(const scoped_install &) = delete;
+            scoped_install & operator=(const scoped_install &) = delete;
+        private:
+            const java_exception_dispatcher * m_previous;
+        };
+    public:
+        java_exception_dispatcher() = default;
+        java_exception_dispatcher(const java_exception_dispatcher &) = delete;
+        java_exception_dispatcher & operator=(const java_exception_dispatcher &) = delete;
+
+        //CppException must derive from java_exception and be constructible from const auto_java_ref<jthrowable> &
+        template<typename CppException, typename T>
+        void add(const java_class<T> & clazz)
+        {
+            static_assert(std::is_base_of_v<java_exception, CppException>, "CppException must derive from java_exception");
+            add(clazz.c_ptr(), [] (jthrowable ex) { throw CppException(ex); });
+        }
+
+        //Throws the C++ exception registered for ex or plain java_exception if none matches
+        [[noreturn]] void raise(JNIEnv * jenv, jthrowable ex) const;
+
+        //Makes java_exception::check use the dispatcher and returns the previously installed one.
+        //Pass nullptr to stop. The dispatcher must outlive its installation, see scoped_install.
+        static const java_exception_dispatcher * install(const java_exception_dispatcher * dispatcher) noexcept;
+    private:
+        void add(jclass clazz, thrower do_throw);
+    private:
+        struct handler
+        {
+            jclass clazz;
+            thrower do_throw;
+        };
+
+        std::vector<handler> m_handlers;
+    };
+}
+
+#endif //HEADER_JAVA_EXCEPTION_DISPATCHER_H_INCLUDED
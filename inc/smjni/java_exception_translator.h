@@ -0,0 +1,63 @@
+/*
+ Copyright 2019 SmJNI Contributors
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#ifndef HEADER_JAVA_EXCEPTION_TRANSLATOR_H_INCLUDED
+#define HEADER_JAVA_EXCEPTION_TRANSLATOR_H_INCLUDED
+
+#include <exception>
+
+#include <smjni/java_exception.h>
+#include <smjni/java_class.h>
+
+namespace smjni
+{
+    //Registry of C++ to Java exception mappings used by java_exception::translate
+    //
+    //Registration and translation may happen concurrently. Registered classes must stay loaded.
+    //Registrations hold global references and are only released by clear() which must be
+    //called before the VM is destroyed.
+    class java_exception_translator
+    {
+    private:
+        typedef bool (*matcher)(const std::exception &);
+    public:
+        java_exception_translator() = delete;
+
+        //C++ exceptions of type CppException (or derived from it) become Java exceptions of class clazz.
+        //Earlier registrations take precedence. The Java class must have a (String) constructor.
+        //If message is given the Java string is created once here and reused instead of what().
+        template<typename CppException, typename T>
+        static void add(JNIEnv * jenv, const java_class<T> & clazz, const char * message = nullptr)
+        {
+            add(jenv, clazz.c_ptr(), message, [] (const std::exception & ex) {
+                return dynamic_cast<const CppException *>(&ex) != nullptr;
+            });
+        }
+
+        //Raises the Java exception registered for ex. Returns false if there is none.
+        static bool raise(JNIEnv * jenv, const std::exception & ex);
+
+        //Raises a Java exception of class clazz with the given message without creating
+        //a String object in native code whenever the message allows it
+        static void throw_new(JNIEnv * jenv, jclass clazz, const char * message);
+
+        static void clear() noexcept;
+    private:
+        static void add(JNIEnv * jenv, jclass clazz, const char * message, matcher matches);
+    };
+}
+
+#endif //HEADER_JAVA_EXCEPTION_TRANSLATOR_H_INCLUDED
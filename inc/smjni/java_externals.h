@@ -27,6 +27,28 @@ namespace smjni
     void set_externals(void (*thrower)(const char *, const char *, va_list), 
                        void (*logger)(const std::exception &, const char *, va_list) noexcept);
     
+    //Without a logger errors are formatted into fixed-size records and written to log_sink
+    //(stderr or logcat by default). Pass nullptr to restore the default sink.
+    void set_externals(void (*thrower)(const char *, const char *, va_list), 
+                       void (*logger)(const std::exception &, const char *, va_list) noexcept,
+                       void (*log_sink)(const char * message) noexcept);
+    
+    //By default records are queued and written to the sink from a background thread so that
+    //logging never blocks on the sink. Records that do not fit the queue are dropped.
+    //When disabled records are written on the calling thread. Disabling waits for the queued records.
+    void set_log_async(bool enabled) noexcept;
+    
+    //Errors logged beyond this many per second are counted and dropped. 0, the default, means no limit.
+    //The sink is told how many records were dropped with the next record it receives.
+    void set_log_rate_limit(unsigned per_second) noexcept;
+    
+    //Waits until all errors logged so far have been passed to the sink
+    void flush_log() noexcept;
+    
+    //Writes out the queued records and stops the background thread. Logging is synchronous afterwards.
+    //The logger is never destroyed so call this before unloading the library if the thread must not outlive it.
+    void shutdown_log() noexcept;
+    
     namespace internal
     {
 #if defined (__GNUC__)
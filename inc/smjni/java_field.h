@@ -18,9 +18,12 @@
 #ifndef HEADER_JAVA_FIELD_H_INCLUDED
 #define HEADER_JAVA_FIELD_H_INCLUDED
 
+#include <atomic>
+
 #include <smjni/java_type_traits.h>
 #include <smjni/java_class.h>
 #include <smjni/java_exception.h>
+#include <smjni/java_call_stats.h>
 
 namespace smjni
 {
@@ -75,44 +78,178 @@ namespace smjni
         {
         }
     };
+
+    //Field id that is looked up on first use rather than on construction.
+    //See java_lazy_method_id for the threading and lifetime rules
+    template<field_kind Kind, typename Type>
+    class java_lazy_field_id
+    {
+    public:
+        java_lazy_field_id() noexcept = default;
+
+        template<typename ClassType>
+        java_lazy_field_id(const java_class<ClassType> & clazz, const char * name) noexcept:
+            m_class(clazz.c_ptr()),
+            m_name(name)
+        {
+        }
+
+        java_lazy_field_id(const java_lazy_field_id & src) noexcept:
+            m_class(src.m_class),
+            m_name(src.m_name),
+            m_id(src.m_id.load(std::memory_order_acquire))
+        {
+        }
+
+        java_lazy_field_id & operator=(const java_lazy_field_id & src) noexcept
+        {
+            m_class = src.m_class;
+            m_name = src.m_name;
+            m_id.store(src.m_id.load(std::memory_order_acquire), std::memory_order_release);
+            return *this;
+        }
+
+        jfieldID get(JNIEnv * jenv) const
+        {
+            jfieldID ret = m_id.load(std::memory_order_acquire);
+            if (!ret)
+                ret = resolve(jenv);
+            return ret;
+        }
+
+    private:
+        SMJNI_NO_INLINE jfieldID resolve(JNIEnv * jenv) const
+        {
+            const char * signature = internal::java_field_signature<Type>();
+            jfieldID ret;
+            if constexpr (Kind == static_field)
+                ret = java_field_id_base::get_static(jenv, m_class, m_name, signature).get();
+            else
+                ret = java_field_id_base::get(jenv, m_class, m_name, signature).get();
+            m_id.store(ret, std::memory_order_release);
+            return ret;
+        }
+
+    private:
+        jclass m_class = nullptr;
+        const char * m_name = nullptr;
+        mutable std::atomic<jfieldID> m_id{nullptr};
+    };
+
+    namespace internal
+    {
+        template<typename Type, typename ThisType>
+        SMJNI_FORCE_INLINE typename java_type_traits<Type>::return_type
+        get_java_field(JNIEnv * jenv, jfieldID id, typename java_type_traits<ThisType>::arg_type object)
+        {
+            typedef java_type_traits<Type> traits;
+
+            Type ret = traits::get_field(jenv, argument_to_java(object), id);
+            if (!ret)
+                java_exception::check(jenv);
+            return return_value_from_java(jenv, ret);
+        }
+
+        template<typename Type, typename ThisType>
+        SMJNI_FORCE_INLINE void
+        set_java_field(JNIEnv * jenv, jfieldID id, typename java_type_traits<ThisType>::arg_type object,
+                       typename java_type_traits<Type>::arg_type val)
+        {
+            typedef java_type_traits<Type> traits;
+
+            traits::set_field(jenv, argument_to_java(object), id, argument_to_java(val));
+            java_exception::check(jenv);
+        }
+
+        template<typename Type>
+        SMJNI_FORCE_INLINE typename java_type_traits<Type>::return_type
+        get_java_static_field(JNIEnv * jenv, jfieldID id, jclass clazz)
+        {
+            typedef java_type_traits<Type> traits;
+
+            Type ret = traits::get_static_field(jenv, clazz, id);
+            if (!ret)
+                java_exception::check(jenv);
+            return return_value_from_java(jenv, ret);
+        }
+
+        template<typename Type>
+        SMJNI_FORCE_INLINE void
+        set_java_static_field(JNIEnv * jenv, jfieldID id, jclass clazz, typename java_type_traits<Type>::arg_type val)
+        {
+            typedef java_type_traits<Type> traits;
+
+            traits::set_static_field(jenv, clazz, id, argument_to_java(val));
+            java_exception::check(jenv);
+        }
+    }
     
     template<typename Type, typename ThisType>
-    class java_field
+    class java_field : private internal::java_call_sites<2>
     {
     private:
         typedef java_field_id<instance_field, Type> id_type;
+        typedef internal::java_call_sites<2> sites;
         typedef java_type_traits<Type> traits;
     public:
         typedef typename traits::return_type return_type;
     public:
         java_field() = default;
         java_field(JNIEnv * jenv, const java_class<ThisType> & clazz, const char* name):
+            sites(internal::java_call_site_class<ThisType>::get(), name, internal::java_field_signature<Type>(), "field_get", "field_set"),
             m_id(jenv, clazz, name)
         {
         }
         
         return_type get(JNIEnv * jenv, typename java_type_traits<ThisType>::arg_type object) const
         {
-            Type ret = traits::get_field(jenv, argument_to_java(object), this->m_id.get());
-            if (!ret)
-                java_exception::check(jenv);
-            return return_value_from_java(jenv, ret);
+            internal::java_call_timer timer(this->site(0));
+            return internal::get_java_field<Type, ThisType>(jenv, this->m_id.get(), object);
         }
         
         void set(JNIEnv * jenv, typename java_type_traits<ThisType>::arg_type object, typename java_type_traits<Type>::arg_type val) const
         {
-            traits::set_field(jenv, argument_to_java(object), this->m_id.get(), argument_to_java(val));
-            java_exception::check(jenv);
+            internal::java_call_timer timer(this->site(1));
+            internal::set_java_field<Type, ThisType>(jenv, this->m_id.get(), object, val);
+        }
+    private:
+        id_type m_id;
+    };
+    
+    template<typename Type, typename ThisType>
+    class java_lazy_field
+    {
+    private:
+        typedef java_lazy_field_id<instance_field, Type> id_type;
+        typedef java_type_traits<Type> traits;
+    public:
+        typedef typename traits::return_type return_type;
+    public:
+        java_lazy_field() = default;
+        java_lazy_field(JNIEnv *, const java_class<ThisType> & clazz, const char* name) noexcept:
+            m_id(clazz, name)
+        {
+        }
+        
+        return_type get(JNIEnv * jenv, typename java_type_traits<ThisType>::arg_type object) const
+        {
+            return internal::get_java_field<Type, ThisType>(jenv, this->m_id.get(jenv), object);
+        }
+        
+        void set(JNIEnv * jenv, typename java_type_traits<ThisType>::arg_type object, typename java_type_traits<Type>::arg_type val) const
+        {
+            internal::set_java_field<Type, ThisType>(jenv, this->m_id.get(jenv), object, val);
         }
     private:
         id_type m_id;
     };
     
     template<typename Type, typename ClassType>
-    class java_static_field
+    class java_static_field : private internal::java_call_sites<2>
     {
     private:
         typedef java_field_id<static_field, Type> id_type;
+        typedef internal::java_call_sites<2> sites;
         typedef java_type_traits<Type> traits;
     public:
         typedef typename traits::return_type return_type;
@@ -120,22 +257,50 @@ namespace smjni
         java_static_field() = default;
         
         java_static_field(JNIEnv * jenv, const java_class<ClassType> & clazz, const char* name):
+            sites(internal::java_call_site_class<ClassType>::get(), name, internal::java_field_signature<Type>(), "static_field_get", "static_field_set"),
             m_id(jenv, clazz, name)
         {
         }
         
         return_type get(JNIEnv * jenv, const java_class<ClassType> & clazz) const
         {
-            Type ret = traits::get_static_field(jenv, clazz.c_ptr(), this->m_id.get());
-            if (!ret)
-                java_exception::check(jenv);
-            return return_value_from_java(jenv, ret);
+            internal::java_call_timer timer(this->site(0));
+            return internal::get_java_static_field<Type>(jenv, this->m_id.get(), clazz.c_ptr());
         }
         
         void set(JNIEnv * jenv, const java_class<ClassType> & clazz, typename java_type_traits<Type>::arg_type val) const
         {
-            traits::set_static_field(jenv, clazz.c_ptr(), this->m_id.get(), argument_to_java(val));
-            java_exception::check(jenv);
+            internal::java_call_timer timer(this->site(1));
+            internal::set_java_static_field<Type>(jenv, this->m_id.get(), clazz.c_ptr(), val);
+        }
+    private:
+        id_type m_id;
+    };
+    
+    template<typename Type, typename ClassType>
+    class java_lazy_static_field
+    {
+    private:
+        typedef java_lazy_field_id<static_field, Type> id_type;
+        typedef java_type_traits<Type> traits;
+    public:
+        typedef typename traits::return_type return_type;
+    public:
+        java_lazy_static_field() = default;
+        
+        java_lazy_static_field(JNIEnv *, const java_class<ClassType> & clazz, const char* name) noexcept:
+            m_id(clazz, name)
+        {
+        }
+        
+        return_type get(JNIEnv * jenv, const java_class<ClassType> & clazz) const
+        {
+            return internal::get_java_static_field<Type>(jenv, this->m_id.get(jenv), clazz.c_ptr());
+        }
+        
+        void set(JNIEnv * jenv, const java_class<ClassType> & clazz, typename java_type_traits<Type>::arg_type val) const
+        {
+            internal::set_java_static_field<Type>(jenv, this->m_id.get(jenv), clazz.c_ptr(), val);
         }
     private:
         id_type m_id;
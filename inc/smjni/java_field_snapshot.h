@@ -0,0 +1,140 @@
+/*
+ Copyright 2019 SmJNI Contributors
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#ifndef HEADER_JAVA_FIELD_SNAPSHOT_H_INCLUDED
+#define HEADER_JAVA_FIELD_SNAPSHOT_H_INCLUDED
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include <smjni/java_runtime.h>
+#include <smjni/java_method.h>
+#include <smjni/java_direct_buffer.h>
+
+namespace smjni
+{
+    namespace internal
+    {
+        //Snapshot slots carry the raw bits of one primitive field each, the way the generated
+        //Java helper packs them: floats via floatToRawIntBits, doubles via doubleToRawLongBits
+        template<typename T>
+        T from_snapshot_slot(jlong slot) noexcept
+        {
+            if constexpr (std::is_same_v<T, jboolean>)
+            {
+                return slot != 0 ? JNI_TRUE : JNI_FALSE;
+            }
+            else if constexpr (std::is_same_v<T, jfloat>)
+            {
+                uint32_t bits = uint32_t(slot);
+                jfloat ret;
+                memcpy(&ret, &bits, sizeof(ret));
+                return ret;
+            }
+            else if constexpr (std::is_same_v<T, jdouble>)
+            {
+                jdouble ret;
+                memcpy(&ret, &slot, sizeof(ret));
+                return ret;
+            }
+            else
+            {
+                return T(slot);
+            }
+        }
+
+        template<typename T>
+        jlong to_snapshot_slot(T value) noexcept
+        {
+            if constexpr (std::is_same_v<T, jboolean>)
+            {
+                return value ? 1 : 0;
+            }
+            else if constexpr (std::is_same_v<T, jfloat>)
+            {
+                int32_t bits;
+                memcpy(&bits, &value, sizeof(bits));
+                return bits;
+            }
+            else if constexpr (std::is_same_v<T, jdouble>)
+            {
+                jlong ret;
+                memcpy(&ret, &value, sizeof(ret));
+                return ret;
+            }
+            else
+            {
+                return jlong(value);
+            }
+        }
+    }
+
+    //Native memory the generated Java helper reads and writes snapshot slots through as a direct
+    //ByteBuffer so that a transfer is a single call into Java with no allocation on either side.
+    //Create one per thread or per caller and reuse it. It must not be used by two threads at once.
+    template<jsize N>
+    class java_snapshot_buffer
+    {
+    template<typename, typename, jsize> friend class java_field_snapshot;
+    public:
+        java_snapshot_buffer(JNIEnv * env):
+            m_java(java_direct_buffer<jlong>(m_slots, N).to_java(env))
+        {}
+        java_snapshot_buffer(const java_snapshot_buffer &) = delete;
+        java_snapshot_buffer & operator=(const java_snapshot_buffer &) = delete;
+    private:
+        jlong m_slots[N] = {};
+        global_java_ref<jByteBuffer> m_java;
+    };
+
+    //Transfers a group of primitive fields of Type with a single call into Java rather than
+    //one JNI call per field. HelperType is the Java class generated by jnigen for
+    //@ExposeToNative(snapshot = true) with
+    //    static void read(Type obj, ByteBuffer slots)
+    //    static void write(Type obj, ByteBuffer slots)
+    //which access the slots as native order longs.
+    template<typename Type, typename HelperType, jsize N>
+    class java_field_snapshot
+    {
+    public:
+        typedef java_snapshot_buffer<N> buffer;
+
+        java_field_snapshot(JNIEnv * env):
+            m_class(env),
+            m_read(env, m_class, "read"),
+            m_write(env, m_class, "write")
+        {}
+
+        void read(JNIEnv * env, const auto_java_ref<Type> & obj, buffer & buf, jlong (&dest)[N]) const
+        {
+            m_read(env, m_class, obj, buf.m_java);
+            memcpy(dest, buf.m_slots, sizeof(dest));
+        }
+
+        void write(JNIEnv * env, const auto_java_ref<Type> & obj, buffer & buf, const jlong (&src)[N]) const
+        {
+            memcpy(buf.m_slots, src, sizeof(src));
+            m_write(env, m_class, obj, buf.m_java);
+        }
+    private:
+        const java_runtime::simple_java_class<HelperType> m_class;
+        const java_static_method<void, HelperType, Type, jByteBuffer> m_read;
+        const java_static_method<void, HelperType, Type, jByteBuffer> m_write;
+    };
+}
+
+#endif //HEADER_JAVA_FIELD_SNAPSHOT_H_INCLUDED
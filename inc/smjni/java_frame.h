@@ -18,7 +18,12 @@
 #ifndef HEADER_SMJNI_JAVA_FRAME_H_INCLUDED
 #define	HEADER_SMJNI_JAVA_FRAME_H_INCLUDED
 
+#include <optional>
+#include <stdexcept>
+
 #include <smjni/config.h>
+#include <smjni/java_exception.h>
+#include <smjni/local_ref_budget.h>
 
 namespace smjni
 {
@@ -27,7 +32,8 @@ namespace smjni
     public:
         java_frame(JNIEnv * env, jint capacity):
             m_env(env),
-            m_pushed(false)
+            m_pushed(false),
+            m_saved_live(local_ref_budget::live())
         {
             int ret = m_env->PushLocalFrame(capacity);
             if (ret != 0)
@@ -41,7 +47,10 @@ namespace smjni
         ~java_frame()
         {
             if (m_pushed)
+            {
                 m_env->PopLocalFrame(nullptr);
+                local_ref_budget::restore(m_saved_live);
+            }
         }
         
         template<typename T>
@@ -51,6 +60,7 @@ namespace smjni
                 THROW_JAVA_PROBLEM("frame not pushed");
             T ret = static_cast<T>(m_env->PopLocalFrame(obj));
             m_pushed = false;
+            local_ref_budget::restore(m_saved_live);
             return ret;
         }
         
@@ -62,6 +72,85 @@ namespace smjni
     private:
         JNIEnv * m_env;
         bool m_pushed;
+        size_t m_saved_live;
+    };
+    
+    //Guarantees room for capacity more local references in the current frame.
+    //With SMJNI_TRACK_LOCAL_REFS on, logs an error on destruction if the scope used more than it asked for.
+    class ensure_local_capacity
+    {
+    public:
+        ensure_local_capacity(JNIEnv * env, jint capacity):
+            m_capacity(size_t(capacity)),
+            m_start(local_ref_budget::live()),
+            m_saved_high_water_mark(local_ref_budget::high_water_mark())
+        {
+            if (env->EnsureLocalCapacity(capacity) != 0)
+            {
+                java_exception::check(env);
+                THROW_JAVA_PROBLEM("cannot ensure local capacity of %d", int(capacity));
+            }
+            local_ref_budget::reset_high_water_mark();
+        }
+        
+        ~ensure_local_capacity() noexcept
+        {
+            if constexpr (local_ref_budget::enabled)
+            {
+                size_t high_water_mark = local_ref_budget::high_water_mark();
+                if (high_water_mark > m_start + m_capacity)
+                {
+                    internal::do_log_error(std::runtime_error("local reference budget exceeded"), 
+                                           "requested capacity %zu but used %zu local references",
+                                           m_capacity, high_water_mark - m_start);
+                }
+                if (high_water_mark > m_saved_high_water_mark)
+                    m_saved_high_water_mark = high_water_mark;
+                local_ref_budget::restore_high_water_mark(m_saved_high_water_mark);
+            }
+        }
+        
+        ensure_local_capacity(const ensure_local_capacity &) = delete;
+        ensure_local_capacity & operator=(const ensure_local_capacity &) = delete;
+    private:
+        size_t m_capacity;
+        size_t m_start;
+        size_t m_saved_high_water_mark;
+    };
+    
+    //Keeps the local reference table bounded in long loops by replacing the current java_frame
+    //with a fresh one every period iterations. Call next() at the start of each iteration.
+    //Local references created in an iteration must not be used after period more iterations.
+    //
+    //  auto_frame_loop loop(env, 64);
+    //  for(jsize i = 0; i < size; ++i) { loop.next(); ... }
+    class auto_frame_loop
+    {
+    public:
+        auto_frame_loop(JNIEnv * env, jint period, jint refs_per_iteration = 1):
+            m_env(env),
+            m_period(period > 0 ? period : 1),
+            m_capacity(m_period * (refs_per_iteration > 0 ? refs_per_iteration : 1)),
+            m_count(0)
+        {}
+        
+        void next()
+        {
+            if (m_count++ % m_period == 0)
+            {
+                m_frame.reset();
+                m_frame.emplace(m_env, m_capacity);
+            }
+        }
+        
+        auto_frame_loop(const auto_frame_loop &) = delete;
+        auto_frame_loop & operator=(const auto_frame_loop &) = delete;
+    private:
+        JNIEnv * m_env;
+        jint m_period;
+        jint m_capacity;
+        size_t m_count;
+        std::optional<java_frame> m_frame;
     };
 }
 
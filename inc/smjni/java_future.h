@@ -0,0 +1,237 @@
+/*
+ Copyright 2019 SmJNI Contributors
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#ifndef HEADER_JAVA_FUTURE_H_INCLUDED
+#define HEADER_JAVA_FUTURE_H_INCLUDED
+
+#include <atomic>
+#include <exception>
+#include <memory>
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+    #include <coroutine>
+    #define SMJNI_HAS_COROUTINES 1
+#else
+    #define SMJNI_HAS_COROUTINES 0
+#endif
+
+#include <smjni/java_runtime.h>
+#include <smjni/java_thread_pool.h>
+#include <smjni/java_externals.h>
+
+namespace smjni
+{
+    class _jCompletableFuture : public _jobject {};
+    typedef _jCompletableFuture * jCompletableFuture;
+
+    class _jBiConsumer : public _jobject {};
+    typedef _jBiConsumer * jBiConsumer;
+
+    class _jNativeCompletion : public _jBiConsumer {};
+    typedef _jNativeCompletion * jNativeCompletion;
+}
+
+HANDLE_OBJECT_JAVA_TYPE(smjni::jCompletableFuture, "java.util.concurrent.CompletableFuture")
+HANDLE_OBJECT_JAVA_TYPE(smjni::jBiConsumer, "java.util.function.BiConsumer")
+HANDLE_OBJECT_JAVA_TYPE(smjni::jNativeCompletion, "smjni.jnigen.NativeCompletion")
+
+namespace smjni
+{
+    //Receives the outcome of a CompletableFuture. Called exactly once on whichever thread
+    //completes the future. Exactly one of result and error is meaningful
+    class java_completion_callback
+    {
+    public:
+        virtual ~java_completion_callback() noexcept = default;
+        virtual void on_complete(JNIEnv * env, jobject result, jthrowable error) noexcept = 0;
+    };
+
+    //Bridges CompletableFuture completion to native callbacks without blocking a thread on get()
+    //
+    //Relies on smjni.jnigen.NativeCompletion (shipped in the jnigen annotations jar) whose
+    //native method is registered by init(). Call init() after java_runtime::init() on a thread
+    //whose class loader can see that class.
+    class java_completion
+    {
+    private:
+        class future_class : public java_runtime::simple_java_class<jCompletableFuture>
+        {
+        public:
+            future_class(JNIEnv * env):
+                simple_java_class(env),
+                m_when_complete(env, *this, "whenComplete")
+            {}
+
+            void when_complete(JNIEnv * env, const auto_java_ref<jCompletableFuture> & future,
+                               const auto_java_ref<jBiConsumer> & action) const
+                { m_when_complete(env, future, action); }
+        private:
+            const java_method<jCompletableFuture, jCompletableFuture, jBiConsumer> m_when_complete;
+        };
+
+        class completion_class : public java_runtime::simple_java_class<jNativeCompletion>
+        {
+        public:
+            completion_class(JNIEnv * env);
+
+            local_java_ref<jNativeCompletion> ctor(JNIEnv * env, jlong handle) const
+                { return m_ctor(env, *this, handle); }
+        private:
+            static void JNICALL complete(JNIEnv * env, jclass, jlong handle, jobject result, jthrowable error);
+        private:
+            const java_constructor<jNativeCompletion, jlong> m_ctor;
+        };
+    public:
+        static void init(JNIEnv * env);
+        static void term();
+
+        //Arranges for the callback to be invoked when the future completes.
+        //If it is already complete the callback runs before this function returns.
+        //A future that is garbage collected without ever completing never invokes
+        //the callback which is then leaked, so only listen to futures that complete.
+        static void listen(JNIEnv * env, const auto_java_ref<jCompletableFuture> & future,
+                           std::unique_ptr<java_completion_callback> callback);
+    private:
+        java_completion(JNIEnv * env);
+    private:
+        future_class m_future;
+        completion_class m_completion;
+
+        static java_completion * s_instance;
+    };
+
+#if SMJNI_HAS_COROUTINES
+
+    //Executors decide where a coroutine awaiting a Java future is resumed
+
+    //Resumes on the Java thread that completed the future
+    struct resume_inline
+    {
+        void operator()(std::coroutine_handle<> handle) const
+            { handle.resume(); }
+    };
+
+    //Resumes on a java_thread_pool worker, inside its own local frame
+    class resume_on_pool
+    {
+    public:
+        resume_on_pool(java_thread_pool & pool) noexcept:
+            m_pool(&pool)
+        {}
+
+        void operator()(std::coroutine_handle<> handle) const
+            { m_pool->submit([handle] (JNIEnv *) { handle.resume(); }); }
+    private:
+        java_thread_pool * m_pool;
+    };
+
+    //co_await java_await(env, future) suspends until the future completes and yields a global
+    //reference to its result or throws java_exception with its failure.
+    //The awaiting coroutine must not be destroyed while it is suspended here. If the future
+    //never completes the coroutine stays suspended forever and its frame is leaked.
+    template<typename Executor = resume_inline>
+    class java_future_awaiter
+    {
+    private:
+        class completion final : public java_completion_callback
+        {
+        public:
+            completion(java_future_awaiter * owner) noexcept:
+                m_owner(owner)
+            {}
+
+            void on_complete(JNIEnv *, jobject result, jthrowable error) noexcept override
+                { m_owner->complete(result, error); }
+        private:
+            java_future_awaiter * m_owner;
+        };
+    public:
+        java_future_awaiter(JNIEnv * env, const auto_java_ref<jCompletableFuture> & future, Executor executor):
+            m_env(env),
+            m_future(future),
+            m_executor(std::move(executor))
+        {}
+
+        java_future_awaiter(const java_future_awaiter &) = delete;
+        java_future_awaiter & operator=(const java_future_awaiter &) = delete;
+
+        bool await_ready() const noexcept
+            { return false; }
+
+        bool await_suspend(std::coroutine_handle<> handle)
+        {
+            m_handle = handle;
+            java_completion::listen(m_env, m_future, std::make_unique<completion>(this));
+            //whoever comes second, the callback or us, decides how to continue
+            return !m_done.exchange(true, std::memory_order_acq_rel);
+        }
+
+        global_java_ref<jobject> await_resume()
+        {
+            if (m_failure)
+                std::rethrow_exception(m_failure);
+            if (m_error)
+                throw java_exception(m_error);
+            return std::move(m_result);
+        }
+    private:
+        void complete(jobject result, jthrowable error) noexcept
+        {
+            try
+            {
+                if (error)
+                    m_error = global_java_ref<jthrowable>(jauto(error));
+                else
+                    m_result = global_java_ref<jobject>(jauto(result));
+            }
+            catch(...)
+            {
+                m_failure = std::current_exception();
+            }
+            if (!m_done.exchange(true, std::memory_order_acq_rel))
+                return;
+            try
+            {
+                m_executor(m_handle);
+            }
+            catch(std::exception & ex)
+            {
+                internal::do_log_error(ex, "unable to schedule coroutine, resuming it inline");
+                m_handle.resume();
+            }
+        }
+    private:
+        JNIEnv * m_env;
+        global_java_ref<jCompletableFuture> m_future;
+        Executor m_executor;
+        std::coroutine_handle<> m_handle;
+        std::atomic<bool> m_done{false};
+        global_java_ref<jobject> m_result;
+        global_java_ref<jthrowable> m_error;
+        std::exception_ptr m_failure;
+    };
+
+    template<typename Executor = resume_inline>
+    java_future_awaiter<Executor> java_await(JNIEnv * env, const auto_java_ref<jCompletableFuture> & future,
+                                             Executor executor = Executor())
+    {
+        return java_future_awaiter<Executor>(env, future, std::move(executor));
+    }
+
+#endif
+}
+
+#endif //HEADER_JAVA_FUTURE_H_INCLUDED
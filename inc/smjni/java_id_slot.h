@@ -0,0 +1,61 @@
+/*
+ Copyright 2019 SmJNI Contributors
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#ifndef HEADER_JAVA_ID_SLOT_H_INCLUDED
+#define HEADER_JAVA_ID_SLOT_H_INCLUDED
+
+#include <atomic>
+#include <cassert>
+#include <type_traits>
+
+#include <smjni/java_types.h>
+
+namespace smjni
+{
+    //Method or field id stored in a constant initialized variable, as used by jnigen
+    //@ExposeToNative(inlineAccessors = true) classes.
+    //
+    //The slot is filled when the generated class is constructed, which java_class_table::init() does
+    //in every mode, normally in JNI_OnLoad. It is never cleared since ids stay valid for as long as
+    //the class is loaded. Using a slot before that is a bug that debug builds assert on.
+    //Reads are relaxed so the accessor using it compiles to a plain load followed by the JNI call.
+    //Any thread using the slot must therefore be ordered after the initialization, which is always
+    //the case for threads started or called into after JNI_OnLoad returns.
+    template<typename Id>
+    class java_id_slot
+    {
+        static_assert(std::is_same_v<Id, jmethodID> || std::is_same_v<Id, jfieldID>, "only method and field ids can be stored");
+    public:
+        constexpr java_id_slot() noexcept = default;
+        java_id_slot(const java_id_slot &) = delete;
+        java_id_slot & operator=(const java_id_slot &) = delete;
+
+        Id get() const noexcept
+        {
+            Id ret = m_id.load(std::memory_order_relaxed);
+            assert(ret && "inline accessor used before its class was constructed");
+            return ret;
+        }
+
+        //Concurrent lookups of the same id produce the same value so the last store is as good as any
+        void set(Id id) noexcept
+            { m_id.store(id, std::memory_order_relaxed); }
+    private:
+        std::atomic<Id> m_id{nullptr};
+    };
+}
+
+#endif //HEADER_JAVA_ID_SLOT_H_INCLUDED
@@ -18,9 +18,12 @@
 #ifndef HEADER_JAVA_METHOD_H_INCLUDED
 #define	HEADER_JAVA_METHOD_H_INCLUDED
 
+#include <atomic>
+
 #include <smjni/java_type_traits.h>
 #include <smjni/java_class.h>
 #include <smjni/java_exception.h>
+#include <smjni/java_call_stats.h>
 
 namespace smjni
 {
@@ -84,12 +87,143 @@ namespace smjni
         {
         }
     };
+
+    //Method id that is looked up on first use rather than on construction.
+    //The id itself serves as a once-flag: after it is published the fast path is a single acquire load.
+    //Concurrent first calls may all perform the lookup but this is benign since they obtain the same id.
+    //The class passed to the constructor must outlive this object (normally it is the enclosing class wrapper)
+    template<method_kind Kind, typename ReturnType, typename... ArgType>
+    class java_lazy_method_id
+    {
+    public:
+        java_lazy_method_id() noexcept = default;
+
+        template<typename ClassType>
+        java_lazy_method_id(const java_class<ClassType> & clazz, const char * name) noexcept:
+            m_class(clazz.c_ptr()),
+            m_name(name)
+        {
+        }
+
+        java_lazy_method_id(const java_lazy_method_id & src) noexcept:
+            m_class(src.m_class),
+            m_name(src.m_name),
+            m_id(src.m_id.load(std::memory_order_acquire))
+        {
+        }
+
+        java_lazy_method_id & operator=(const java_lazy_method_id & src) noexcept
+        {
+            m_class = src.m_class;
+            m_name = src.m_name;
+            m_id.store(src.m_id.load(std::memory_order_acquire), std::memory_order_release);
+            return *this;
+        }
+
+        jmethodID get(JNIEnv * jenv) const
+        {
+            jmethodID ret = m_id.load(std::memory_order_acquire);
+            if (!ret)
+                ret = resolve(jenv);
+            return ret;
+        }
+
+    private:
+        SMJNI_NO_INLINE jmethodID resolve(JNIEnv * jenv) const
+        {
+            const char * signature = internal::java_method_signature<ReturnType, ArgType...>();
+            jmethodID ret;
+            if constexpr (Kind == static_method)
+                ret = java_method_id_base::get_static(jenv, m_class, m_name, signature).get();
+            else
+                ret = java_method_id_base::get(jenv, m_class, m_name, signature).get();
+            m_id.store(ret, std::memory_order_release);
+            return ret;
+        }
+
+    private:
+        jclass m_class = nullptr;
+        const char * m_name = nullptr;
+        mutable std::atomic<jmethodID> m_id{nullptr};
+    };
+
+    namespace internal
+    {
+        template<typename ReturnType, typename ThisType, typename... ArgType>
+        SMJNI_FORCE_INLINE typename java_type_traits<ReturnType>::return_type
+        call_java_method(JNIEnv * jenv, jmethodID id,
+                         typename java_type_traits<ThisType>::arg_type object,
+                         typename java_type_traits<ArgType>::arg_type... params)
+        {
+            typedef java_type_traits<ReturnType> traits;
+
+            auto ret = traits::call_method(jenv,
+                                           object.c_ptr(),
+                                           id,
+                                           argument_to_java(params)...);
+            if (!ret)
+                java_exception::check(jenv);
+            return return_value_from_java(jenv, ret);
+        }
+
+        template<typename ReturnType, typename ThisType, typename... ArgType>
+        SMJNI_FORCE_INLINE typename java_type_traits<ReturnType>::return_type
+        call_java_non_virtual_method(JNIEnv * jenv, jmethodID id,
+                                     typename java_type_traits<ThisType>::arg_type object,
+                                     jclass clazz,
+                                     typename java_type_traits<ArgType>::arg_type... params)
+        {
+            typedef java_type_traits<ReturnType> traits;
+
+            auto ret = traits::call_non_virtual_method(jenv,
+                                                       argument_to_java(object),
+                                                       clazz,
+                                                       id,
+                                                       argument_to_java(params)...);
+            if (!ret)
+                java_exception::check(jenv);
+            return return_value_from_java(jenv, ret);
+        }
+
+        template<typename ReturnType, typename... ArgType>
+        SMJNI_FORCE_INLINE typename java_type_traits<ReturnType>::return_type
+        call_java_static_method(JNIEnv * jenv, jmethodID id, jclass clazz,
+                                typename java_type_traits<ArgType>::arg_type... params)
+        {
+            typedef java_type_traits<ReturnType> traits;
+
+            auto ret = traits::call_static_method(jenv,
+                                                  clazz,
+                                                  id,
+                                                  argument_to_java(params)...);
+            if (!ret)
+                java_exception::check(jenv);
+            return return_value_from_java(jenv, ret);
+        }
+
+        template<typename ReturnType, typename... ArgType>
+        SMJNI_FORCE_INLINE typename java_type_traits<ReturnType>::return_type
+        call_java_constructor(JNIEnv * jenv, jmethodID id, jclass clazz,
+                              typename java_type_traits<ArgType>::arg_type... params)
+        {
+            typedef java_type_traits<ReturnType> traits;
+
+            auto ret = traits::new_object(jenv,
+                                          clazz,
+                                          id,
+                                          argument_to_java(params)...);
+            if (!ret)
+                java_exception::check(jenv);
+            return return_value_from_java(jenv, ret);
+        }
+    }
     
     template<typename ReturnType, typename ThisType, typename... ArgType>
-    class java_method
+    class java_method : private internal::java_call_sites<1>
     {
     private:
         typedef java_method_id<instance_method, ReturnType, ArgType...> id_type;
+        typedef internal::java_call_sites<1> sites;
         typedef java_type_traits<ReturnType> traits;
     public:
         typedef typename traits::return_type return_type;
@@ -97,6 +231,7 @@ namespace smjni
         java_method() = default;
         
         java_method(JNIEnv * jenv, const java_class<ThisType> & clazz, const char* name):
+            sites(internal::java_call_site_class<ThisType>::get(), name, internal::java_method_signature<ReturnType, ArgType...>(), "method"),
             m_id(jenv, clazz, name)
         {
         }
@@ -104,13 +239,8 @@ namespace smjni
         return_type operator()(JNIEnv * jenv, typename java_type_traits<ThisType>::arg_type object, 
                                typename java_type_traits<ArgType>::arg_type... params) const
         {
-            auto ret = traits::call_method(jenv,
-                                           object.c_ptr(),
-                                           this->m_id.get(),
-                                           argument_to_java(params)...);
-            if (!ret)
-                java_exception::check(jenv);
-            return return_value_from_java(jenv, ret);
+            internal::java_call_timer timer(this->site(0));
+            return internal::call_java_method<ReturnType, ThisType, ArgType...>(jenv, this->m_id.get(), object, params...);
         }
         
         template<typename ClassType>
@@ -118,14 +248,42 @@ namespace smjni
                                      const java_class<ClassType> & clazz, 
                                      typename java_type_traits<ArgType>::arg_type... params) const
         {
-            auto ret = traits::call_non_virtual_method(jenv,
-                                                       argument_to_java(object),
-                                                       clazz.c_ptr(),
-                                                       this->m_id.get(),
-                                                       argument_to_java(params)...);
-            if (!ret)
-                java_exception::check(jenv);
-            return return_value_from_java(jenv, ret);
+            internal::java_call_timer timer(this->site(0));
+            return internal::call_java_non_virtual_method<ReturnType, ThisType, ArgType...>(jenv, this->m_id.get(), object, clazz.c_ptr(), params...);
+        }
+        
+    private:
+        id_type m_id;
+    };
+    
+    template<typename ReturnType, typename ThisType, typename... ArgType>
+    class java_lazy_method
+    {
+    private:
+        typedef java_lazy_method_id<instance_method, ReturnType, ArgType...> id_type;
+        typedef java_type_traits<ReturnType> traits;
+    public:
+        typedef typename traits::return_type return_type;
+    public:
+        java_lazy_method() = default;
+        
+        java_lazy_method(JNIEnv *, const java_class<ThisType> & clazz, const char* name) noexcept:
+            m_id(clazz, name)
+        {
+        }
+        
+        return_type operator()(JNIEnv * jenv, typename java_type_traits<ThisType>::arg_type object, 
+                               typename java_type_traits<ArgType>::arg_type... params) const
+        {
+            return internal::call_java_method<ReturnType, ThisType, ArgType...>(jenv, this->m_id.get(jenv), object, params...);
+        }
+        
+        template<typename ClassType>
+        return_type call_non_virtual(JNIEnv * jenv, typename java_type_traits<ThisType>::arg_type object,
+                                     const java_class<ClassType> & clazz, 
+                                     typename java_type_traits<ArgType>::arg_type... params) const
+        {
+            return internal::call_java_non_virtual_method<ReturnType, ThisType, ArgType...>(jenv, this->m_id.get(jenv), object, clazz.c_ptr(), params...);
         }
         
     private:
@@ -133,10 +291,11 @@ namespace smjni
     };
     
     template<typename ReturnType, typename ClassType, typename... ArgType>
-    class java_static_method
+    class java_static_method : private internal::java_call_sites<1>
     {
     private:
         typedef java_method_id<static_method, ReturnType, ArgType...> id_type;
+        typedef internal::java_call_sites<1> sites;
         typedef java_type_traits<ReturnType> traits;
     public:
         typedef typename traits::return_type return_type;
@@ -144,48 +303,88 @@ namespace smjni
         java_static_method() = default;
         
         java_static_method(JNIEnv * jenv, const java_class<ClassType> & clazz, const char* name):
+            sites(internal::java_call_site_class<ClassType>::get(), name, internal::java_method_signature<ReturnType, ArgType...>(), "static_method"),
             m_id(jenv, clazz, name)
         {
         }
         
         return_type operator()(JNIEnv * jenv, const java_class<ClassType> & clazz, typename java_type_traits<ArgType>::arg_type... params) const
         {
-            auto ret = traits::call_static_method(jenv,
-                                                  clazz.c_ptr(),
-                                                  this->m_id.get(),
-                                                  argument_to_java(params)...);
-            if (!ret)
-                java_exception::check(jenv);
-            return return_value_from_java(jenv, ret);
+            internal::java_call_timer timer(this->site(0));
+            return internal::call_java_static_method<ReturnType, ArgType...>(jenv, this->m_id.get(), clazz.c_ptr(), params...);
+        }
+    private:
+        id_type m_id;
+    };
+    
+    template<typename ReturnType, typename ClassType, typename... ArgType>
+    class java_lazy_static_method
+    {
+    private:
+        typedef java_lazy_method_id<static_method, ReturnType, ArgType...> id_type;
+        typedef java_type_traits<ReturnType> traits;
+    public:
+        typedef typename traits::return_type return_type;
+    public:
+        java_lazy_static_method() = default;
+        
+        java_lazy_static_method(JNIEnv *, const java_class<ClassType> & clazz, const char* name) noexcept:
+            m_id(clazz, name)
+        {
+        }
+        
+        return_type operator()(JNIEnv * jenv, const java_class<ClassType> & clazz, typename java_type_traits<ArgType>::arg_type... params) const
+        {
+            return internal::call_java_static_method<ReturnType, ArgType...>(jenv, this->m_id.get(jenv), clazz.c_ptr(), params...);
         }
     private:
         id_type m_id;
     };
     
     template<typename ReturnType, typename... ArgType>
-    class java_constructor
+    class java_constructor : private internal::java_call_sites<1>
     {
     private:
         typedef java_method_id<constructor, void, ArgType...> id_type;
+        typedef internal::java_call_sites<1> sites;
         typedef java_type_traits<ReturnType> traits;
     public:
         typedef typename traits::return_type return_type;
     public:
         java_constructor() = default;
         java_constructor(JNIEnv * jenv, const java_class<ReturnType> & clazz):
+            sites(internal::java_call_site_class<ReturnType>::get(), "<init>", internal::java_method_signature<void, ArgType...>(), "constructor"),
             m_id(jenv, clazz)
         {
         }
         
         return_type operator()(JNIEnv * jenv, const java_class<ReturnType> & clazz, typename java_type_traits<ArgType>::arg_type... params) const
         {
-            auto ret = traits::new_object(jenv,
-                                          clazz.c_ptr(),
-                                          this->m_id.get(),
-                                          argument_to_java(params)...);
-            if (!ret)
-                java_exception::check(jenv);
-            return return_value_from_java(jenv, ret);
+            internal::java_call_timer timer(this->site(0));
+            return internal::call_java_constructor<ReturnType, ArgType...>(jenv, this->m_id.get(), clazz.c_ptr(), params...);
+        }
+    private:
+        id_type m_id;
+    };
+    
+    template<typename ReturnType, typename... ArgType>
+    class java_lazy_constructor
+    {
+    private:
+        typedef java_lazy_method_id<constructor, void, ArgType...> id_type;
+        typedef java_type_traits<ReturnType> traits;
+    public:
+        typedef typename traits::return_type return_type;
+    public:
+        java_lazy_constructor() = default;
+        java_lazy_constructor(JNIEnv *, const java_class<ReturnType> & clazz) noexcept:
+            m_id(clazz, "<init>")
+        {
+        }
+        
+        return_type operator()(JNIEnv * jenv, const java_class<ReturnType> & clazz, typename java_type_traits<ArgType>::arg_type... params) const
+        {
+            return internal::call_java_constructor<ReturnType, ArgType...>(jenv, this->m_id.get(jenv), clazz.c_ptr(), params...);
         }
     private:
         id_type m_id;
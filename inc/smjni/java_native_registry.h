@@ -0,0 +1,92 @@
+/*
+ Copyright 2019 SmJNI Contributors
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#ifndef HEADER_JAVA_NATIVE_REGISTRY_H_INCLUDED
+#define HEADER_JAVA_NATIVE_REGISTRY_H_INCLUDED
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <type_traits>
+#include <vector>
+
+#include <smjni/java_runtime.h>
+#include <smjni/java_class_table.h>
+
+namespace smjni
+{
+    struct java_natives_timing
+    {
+        const char * name;
+        //obtaining the class reference, negligible if it was already loaded
+        std::chrono::nanoseconds lookup;
+        std::chrono::nanoseconds registration;
+        jint method_count;
+    };
+
+    namespace internal
+    {
+        struct java_native_class_entry
+        {
+            const char * name;
+            jclass (*load)(JNIEnv * env);
+            std::atomic<bool> * registered;
+            const JNINativeMethod * methods;
+            jint method_count;
+        };
+
+        template<typename Class>
+        jclass load_native_class(JNIEnv * env)
+        {
+            typedef decltype(java_type_of_class((const Class *)nullptr)) java_type;
+            return java_runtime::simple_java_class<java_type>(env).c_ptr();
+        }
+
+        template<typename Class>
+        constexpr java_native_class_entry make_native_class_entry() noexcept
+        {
+            typedef decltype(java_type_of_class((const Class *)nullptr)) java_type;
+            return { java_type_traits<java_type>::class_name(),
+                     &load_native_class<Class>,
+                     &java_natives_registered_v<Class>,
+                     Class::native_methods,
+                     jint(std::extent_v<decltype(Class::native_methods)>) };
+        }
+
+        //One constant initialized table for all classes passed to register_all_natives
+        template<typename... Classes>
+        inline constexpr std::array<java_native_class_entry, sizeof...(Classes)> java_native_table_v = {
+            make_native_class_entry<Classes>()...
+        };
+
+        std::vector<java_natives_timing> register_native_classes(JNIEnv * env, const java_native_class_entry * entries, size_t count);
+    }
+
+    //Registers native methods of all the given classes in a single pass, typically from JNI_OnLoad.
+    //Classes are the jnigen generated classes listed in JNIGEN_ALL_NATIVE_CLASSES.
+    //
+    //Class references already published by java_class are reused. Classes registered here are
+    //not registered again when a java_class_table constructs them, and lazy tables no longer
+    //construct them eagerly in init().
+    template<typename... Classes>
+    std::vector<java_natives_timing> register_all_natives(JNIEnv * env)
+    {
+        const auto & table = internal::java_native_table_v<Classes...>;
+        return internal::register_native_classes(env, table.data(), table.size());
+    }
+}
+
+#endif //HEADER_JAVA_NATIVE_REGISTRY_H_INCLUDED
@@ -22,6 +22,8 @@
 #include <exception>
 
 #include <smjni/jni_provider.h>
+#include <smjni/global_ref_pool.h>
+#include <smjni/local_ref_budget.h>
 #include <smjni/java_externals.h>
 #include <smjni/java_cast.h>
 
@@ -29,6 +31,8 @@ namespace smjni
 {
     template<typename T, typename Traits>
     class java_ref;
+    template<typename T>
+    class unique_local_ref;
     
     namespace internal
     {
@@ -36,6 +40,11 @@ namespace smjni
         template<typename Traits, typename T> java_ref<T, Traits> attach_java_ref(JNIEnv * env, T ptr);
     }
     
+    namespace internal
+    {
+        class local_ref_traits;
+    }
+
     template<typename T, typename Traits>
     class java_ref : private Traits
     {
@@ -47,6 +56,10 @@ namespace smjni
 
         template<typename X>
         using allow_conversion_from = typename Traits:: template allow_conversion_from<X>;
+
+        //true for local_java_ref only, dependent on Y so that it can be used for SFINAE
+        template<typename Y>
+        static constexpr bool is_local_from_unique = std::is_same_v<Traits, internal::local_ref_traits> && sizeof(Y) != 0;
     public:
         java_ref() noexcept:
             traits(nullptr),
@@ -78,6 +91,14 @@ namespace smjni
             m_obj(this->new_ref(jstatic_cast<T>(src.c_ptr())))
         {}
         
+        //A unique_local_ref can only be moved into a local_java_ref. Copying it needs an explicit share()
+        template<typename Y>
+        java_ref(const unique_local_ref<Y> & src, std::enable_if_t<is_local_from_unique<Y>, void*> = nullptr) = delete;
+        template<typename Y>
+        java_ref(unique_local_ref<Y> && src, std::enable_if_t<is_local_from_unique<Y> && is_java_castable_v<Y, T>, void*> = nullptr) noexcept:
+            java_ref(static_cast<java_ref<Y, Traits> &&>(src))
+        {}
+
         java_ref(java_ref && src) noexcept:
             traits(std::move(static_cast<traits &>(src))),
             m_obj(src.m_obj)
@@ -104,6 +125,15 @@ namespace smjni
             java_ref(src).swap(*this);
             return *this;
         }
+        template<typename Y>
+        std::enable_if_t<is_local_from_unique<Y>,
+        java_ref> & operator=(const unique_local_ref<Y> & src) = delete;
+        template<typename Y>
+        std::enable_if_t<is_local_from_unique<Y> && is_java_castable_v<Y, T>,
+        java_ref> & operator=(unique_local_ref<Y> && src) noexcept
+        {
+            return *this = static_cast<java_ref<Y, Traits> &&>(src);
+        }
         java_ref & operator=(java_ref && src) noexcept
         {
             this->delete_ref();
@@ -145,6 +175,7 @@ namespace smjni
         {
             T ret = this->m_obj;
             this->m_obj = 0;
+            traits::on_release(ret);
             return traits::c_ptr(ret);
         }
         
@@ -153,7 +184,7 @@ namespace smjni
         
         java_ref(JNIEnv * env, T obj, attach_tag) noexcept:
             traits(env),
-            m_obj(obj)
+            m_obj(static_cast<T>(traits::adopt_ref(obj)))
         {}
         java_ref(JNIEnv * env, T obj) noexcept:
             traits(env),
@@ -169,6 +200,7 @@ namespace smjni
             catch(std::exception & ex)
             {
                 internal::do_log_error(ex, nullptr);
+                flush_log();
                 std::terminate();
             }
         }
@@ -213,8 +245,12 @@ namespace smjni
 
             static jobject new_ref(jobject obj) noexcept
                 { return obj; }
+            static jobject adopt_ref(jobject obj) noexcept
+                { return obj; }
             static void delete_ref(jobject obj) noexcept
                 {  }
+            static void on_release(jobject obj) noexcept
+                {  }
             template<typename T>
             static T c_ptr(T obj) noexcept
                 { return obj; }
@@ -235,11 +271,45 @@ namespace smjni
             local_ref_traits(const java_ref_traits & ):
                 m_env(jni_provider::get_jni())
             {}
+            //Copying a local reference costs a NewLocalRef call
+            //Define SMJNI_WARN_LOCAL_REF_COPIES to have every such copy flagged at compile time
+#ifdef SMJNI_WARN_LOCAL_REF_COPIES
+            [[deprecated("copying local_java_ref calls NewLocalRef, move it or use unique_local_ref")]]
+#endif
+            local_ref_traits(const local_ref_traits &) noexcept = default;
+            local_ref_traits(local_ref_traits &&) noexcept = default;
+            local_ref_traits & operator=(const local_ref_traits &) noexcept = default;
+            local_ref_traits & operator=(local_ref_traits &&) noexcept = default;
 
             jobject new_ref(jobject obj) noexcept
-                { return obj ? m_env->NewLocalRef(obj) : nullptr; }
+            { 
+                if (!obj)
+                    return nullptr;
+                jobject ret = m_env->NewLocalRef(obj);
+                if (ret)
+                    local_ref_budget::on_created();
+                return ret;
+            }
+            static jobject adopt_ref(jobject obj) noexcept
+            {
+                if (obj)
+                    local_ref_budget::on_created();
+                return obj;
+            }
             void delete_ref(jobject obj) noexcept
-                { if (obj) m_env->DeleteLocalRef(obj); }
+            { 
+                if (obj)
+                {
+                    m_env->DeleteLocalRef(obj);
+                    local_ref_budget::on_deleted();
+                }
+            }
+            //the reference now belongs to whoever took it, typically the VM when returned from a native method
+            static void on_release(jobject obj) noexcept
+            {
+                if (obj)
+                    local_ref_budget::on_deleted();
+            }
             template<typename T>
             static T c_ptr(T obj) noexcept
                 { return obj; }
@@ -262,9 +332,25 @@ namespace smjni
             {}
 
             static jobject new_ref(jobject obj) 
-                { return obj ? jni_provider::get_jni()->NewGlobalRef(obj) : nullptr; }
+            { 
+                if (!obj)
+                    return nullptr;
+                jobject ret = jni_provider::get_jni()->NewGlobalRef(obj);
+                if (ret)
+                    global_ref_pool::on_created();
+                return ret;
+            }
+            static jobject adopt_ref(jobject obj) noexcept
+            {
+                if (obj)
+                    global_ref_pool::on_created();
+                return obj;
+            }
             static void delete_ref(jobject obj) 
-                { if (obj) jni_provider::get_jni()->DeleteGlobalRef(obj); }
+                { if (obj) global_ref_pool::release(obj); }
+            //a released global reference is still alive so it stays counted
+            static void on_release(jobject obj) noexcept
+                {  }
             template<typename T>
             static T c_ptr(T obj) noexcept
                 { return obj; }
@@ -286,8 +372,12 @@ namespace smjni
 
             static jweak new_ref(jobject obj)
                 { return obj ? jni_provider::get_jni()->NewWeakGlobalRef(obj) : nullptr; }
+            static jobject adopt_ref(jobject obj) noexcept
+                { return obj; }
             static void delete_ref(jobject obj)
                 { if (obj) jni_provider::get_jni()->DeleteWeakGlobalRef(obj); }
+            static void on_release(jobject obj) noexcept
+                {  }
             template<typename T>
             static jweak c_ptr(T obj) noexcept
                 { return obj; }
@@ -319,6 +409,36 @@ namespace smjni
     template<typename T>
     using weak_java_ref = java_ref<T, internal::weak_ref_traits>;
     
+    //Local reference that can only be moved, never copied, so passing it around never calls NewLocalRef
+    //This is what calls to Java methods and field reads return. It is a local_java_ref so it can be passed
+    //wherever auto_java_ref or local_java_ref is accepted and moved into a local_java_ref for free.
+    //Copying it into a local_java_ref does not compile, use share() when a second reference is needed.
+    template<typename T>
+    class unique_local_ref : public local_java_ref<T>
+    {
+    public:
+        unique_local_ref() noexcept = default;
+        unique_local_ref(std::nullptr_t) noexcept
+        {}
+        unique_local_ref(local_java_ref<T> && src) noexcept:
+            local_java_ref<T>(std::move(src))
+        {}
+        template<typename Y>
+        unique_local_ref(unique_local_ref<Y> && src, std::enable_if_t<is_java_castable_v<Y, T>, void*> = nullptr) noexcept:
+            local_java_ref<T>(static_cast<local_java_ref<Y> &&>(src))
+        {}
+        
+        unique_local_ref(unique_local_ref && src) noexcept = default;
+        unique_local_ref & operator=(unique_local_ref && src) noexcept = default;
+        
+        unique_local_ref(const unique_local_ref &) = delete;
+        unique_local_ref & operator=(const unique_local_ref &) = delete;
+
+        //A new, independent local reference to the same object. Costs a NewLocalRef call
+        local_java_ref<T> share() const
+            { return static_cast<const local_java_ref<T> &>(*this); }
+    };
+    
     template<typename T>
     inline auto_java_ref<T> jauto(T ptr) noexcept
         { return auto_java_ref<T>(ptr); }
@@ -26,6 +26,13 @@
 
 namespace smjni
 {
+    namespace internal
+    {
+        //Class name in the slash separated form FindClass expects, constant initialized
+        template<typename T>
+        inline constexpr auto java_class_path_v = replace(string_array(java_type_traits<T>::class_name()), '.', '/');
+    }
+
     class java_runtime final
     {
     private:
@@ -86,6 +93,16 @@ namespace smjni
            return s_instance->m_throwable; 
         }
         
+        //Instances created at init so that they can be thrown when nothing else can be allocated
+        static const global_java_ref<jthrowable> & out_of_memory_error()
+        {
+           return s_instance->m_out_of_memory_error; 
+        }
+        static const global_java_ref<jthrowable> & stack_overflow_error()
+        {
+           return s_instance->m_stack_overflow_error; 
+        }
+        
         template<typename T> 
         static local_java_ref<jclass> get_class(JNIEnv * env)
         {
@@ -110,6 +127,8 @@ namespace smjni
         
     private:
         java_runtime(JNIEnv * jenv);
+        
+        static global_java_ref<jthrowable> preallocate_error(JNIEnv * jenv, const char * class_name);
             
         template<typename T> 
         static local_java_ref<jclass> get_core_class(JNIEnv * env)
@@ -126,14 +145,13 @@ namespace smjni
         template<typename T> 
         static local_java_ref<jclass> do_find(JNIEnv * jenv)
         {
-            using internal::string_array, internal::transform;
-            static const auto name = transform(string_array(java_type_traits<T>::class_name()),
-                                               [](char c) {return (c != '.' ? c : '/');});
-            return jattach(jenv, jenv->FindClass(name.c_str()));
+            return jattach(jenv, jenv->FindClass(internal::java_class_path_v<T>.c_str()));
         }
     private:
         const object_class m_object;
         const throwable_class m_throwable;
+        const global_java_ref<jthrowable> m_out_of_memory_error;
+        const global_java_ref<jthrowable> m_stack_overflow_error;
         
         static java_runtime * s_instance;
     };
@@ -0,0 +1,172 @@
+/*
+ Copyright 2019 SmJNI Contributors
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#ifndef HEADER_JAVA_THREAD_POOL_H_INCLUDED
+#define HEADER_JAVA_THREAD_POOL_H_INCLUDED
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <smjni/jni_provider.h>
+#include <smjni/java_ref.h>
+#include <smjni/java_frame.h>
+#include <smjni/java_exception.h>
+
+namespace smjni
+{
+    namespace internal
+    {
+        //Results of pool tasks outlive the task's local frame so Java references
+        //are converted to global ones before being handed to the future
+        template<typename T>
+        struct java_pool_result
+        {
+            typedef T type;
+
+            static T && convert(T && val) noexcept
+                { return std::move(val); }
+        };
+
+        template<>
+        struct java_pool_result<void>
+        {
+            typedef void type;
+        };
+
+        template<typename T, typename Traits>
+        struct java_pool_result<java_ref<T, Traits>>
+        {
+            typedef global_java_ref<T> type;
+
+            static type convert(java_ref<T, Traits> && val)
+                { return type(val); }
+        };
+
+        template<typename T>
+        struct java_pool_result<unique_local_ref<T>> : java_pool_result<local_java_ref<T>>
+        {};
+    }
+
+    //Fixed set of worker threads each attached to the VM once, under a meaningful name, for its whole lifetime.
+    //Each worker has its own task queue. Tasks submitted from a worker go to its own queue and idle workers
+    //steal from the others. Every task runs inside its own local frame.
+    class java_thread_pool
+    {
+    private:
+        class task
+        {
+        public:
+            virtual ~task() noexcept = default;
+            virtual void run(JNIEnv * env) noexcept = 0;
+        };
+
+        template<typename Func, typename Result>
+        class packaged_task final : public task
+        {
+        public:
+            packaged_task(Func && func):
+                m_func(std::forward<Func>(func))
+            {}
+
+            std::future<typename internal::java_pool_result<Result>::type> get_future()
+                { return m_promise.get_future(); }
+
+            void run(JNIEnv * env) noexcept override
+            {
+                try
+                {
+                    java_frame frame(env, s_frame_capacity);
+                    if constexpr (std::is_void_v<Result>)
+                    {
+                        m_func(env);
+                        java_exception::check(env);
+                        m_promise.set_value();
+                    }
+                    else
+                    {
+                        auto ret = internal::java_pool_result<Result>::convert(m_func(env));
+                        java_exception::check(env);
+                        m_promise.set_value(std::move(ret));
+                    }
+                }
+                catch(...)
+                {
+                    m_promise.set_exception(std::current_exception());
+                }
+            }
+        private:
+            std::decay_t<Func> m_func;
+            std::promise<typename internal::java_pool_result<Result>::type> m_promise;
+        };
+
+        struct worker_queue
+        {
+            std::mutex mutex;
+            std::deque<std::unique_ptr<task>> tasks;
+        };
+    public:
+        //Thread names are name_prefix-0, name_prefix-1 etc.
+        java_thread_pool(unsigned thread_count, const char * name_prefix = "smjni-worker");
+        ~java_thread_pool() noexcept;
+
+        java_thread_pool(const java_thread_pool &) = delete;
+        java_thread_pool & operator=(const java_thread_pool &) = delete;
+
+        //Func is invoked as func(JNIEnv *) on one of the workers
+        //If it returns a Java reference the future will hold a global_java_ref
+        template<typename Func>
+        auto submit(Func && func) -> std::future<typename internal::java_pool_result<std::invoke_result_t<Func, JNIEnv *>>::type>
+        {
+            typedef packaged_task<Func, std::invoke_result_t<Func, JNIEnv *>> task_type;
+
+            auto new_task = std::make_unique<task_type>(std::forward<Func>(func));
+            auto ret = new_task->get_future();
+            push(std::move(new_task));
+            return ret;
+        }
+
+        unsigned size() const noexcept
+            { return unsigned(m_threads.size()); }
+
+    private:
+        void push(std::unique_ptr<task> new_task);
+        bool pop(size_t index, std::unique_ptr<task> & dest);
+        void run(size_t index, std::string name, std::promise<void> & started);
+        void stop() noexcept;
+
+    private:
+        static constexpr jint s_frame_capacity = 16;
+
+        std::vector<std::unique_ptr<worker_queue>> m_queues;
+        std::vector<std::thread> m_threads;
+        std::atomic<size_t> m_next_queue{0};
+
+        std::mutex m_wait_mutex;
+        std::condition_variable m_wakeup;
+        std::atomic<size_t> m_pending{0};
+        bool m_stopping = false;
+    };
+}
+
+#endif //HEADER_JAVA_THREAD_POOL_H_INCLUDED
@@ -18,6 +18,7 @@
 #ifndef HEADER_JAVA_TYPE_TRAITS_H_INCLUDED
 #define HEADER_JAVA_TYPE_TRAITS_H_INCLUDED
 
+#include <limits>
 
 #include <smjni/java_ref.h>
 #include <smjni/java_types.h>
@@ -59,7 +60,7 @@ namespace smjni
 
     template<typename T> SMJNI_FORCE_INLINE constexpr T return_value_from_java(JNIEnv *, T val) noexcept
         { return val; }
-    template<typename T> SMJNI_FORCE_INLINE local_java_ref<T *> return_value_from_java(JNIEnv * env, T * val) noexcept
+    template<typename T> SMJNI_FORCE_INLINE unique_local_ref<T *> return_value_from_java(JNIEnv * env, T * val) noexcept
         { return jattach(env, val); }
 
     //Allows uniform handling of void return
@@ -77,7 +78,7 @@ namespace smjni
     constexpr inline decltype(auto) object_signature_from_name(const char (&name)[N])
     {
         using internal::string_array;
-        return string_array("L") + transform(string_array(name), [](char c) {return (c != '.' ? c : '/');}) + string_array(";");
+        return string_array("L") + replace(string_array(name), '.', '/') + string_array(";");
     }
 
     template<size_t N>
@@ -236,7 +237,7 @@ namespace smjni
     class java_object_type_base
     {
     public:
-        typedef local_java_ref<T> return_type;
+        typedef unique_local_ref<T> return_type;
         typedef const auto_java_ref<T> & arg_type; 
 
         java_object_type_base() = delete;
@@ -0,0 +1,144 @@
+/*
+ Copyright 2019 SmJNI Contributors
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#ifndef HEADER_JAVA_VM_HOST_H_INCLUDED
+#define HEADER_JAVA_VM_HOST_H_INCLUDED
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <smjni/jni_provider.h>
+#include <smjni/java_class_table.h>
+
+namespace smjni
+{
+    enum class java_gc
+    {
+        vm_default,
+        serial,
+        parallel,
+        g1,
+        z,
+        shenandoah,
+        //no-op collector, useful for short lived tools and benchmarks
+        epsilon
+    };
+
+    //Class data sharing (-Xshare) mode
+    enum class java_cds_mode
+    {
+        vm_default,
+        off,
+        //use the archive if it can be mapped
+        automatic,
+        //fail VM creation if the archive cannot be mapped
+        required
+    };
+
+    struct java_vm_options
+    {
+        std::vector<std::string> class_path;
+        //heap sizes in bytes, 0 leaves the VM default
+        size_t initial_heap = 0;
+        size_t max_heap = 0;
+        java_gc gc = java_gc::vm_default;
+        bool check_jni = false;
+
+        java_cds_mode cds = java_cds_mode::vm_default;
+        //static or dynamic CDS/AppCDS archive to map at startup (-XX:SharedArchiveFile)
+        std::string shared_archive;
+        //dump loaded application classes into a dynamic archive on exit (-XX:ArchiveClassesAtExit, JDK 13+)
+        std::string archive_at_exit;
+
+        //passed to the VM verbatim after all of the above
+        std::vector<std::string> extra;
+        bool ignore_unrecognized = false;
+        jint version = JNI_VERSION_1_6;
+
+        //Path of the JVM shared library. If empty the VM entry points must already be
+        //loaded into the process, for example because the executable links with libjvm
+        std::string jvm_library;
+
+        //Option strings as they will be passed to JNI_CreateJavaVM
+        std::vector<std::string> to_vm_options() const;
+    };
+
+    struct java_vm_startup_timing
+    {
+        std::chrono::nanoseconds load_library{0};
+        std::chrono::nanoseconds create_vm{0};
+        //jni_provider and java_runtime
+        std::chrono::nanoseconds runtime_init{0};
+        //all class tables passed to init_classes
+        std::chrono::nanoseconds classes_init{0};
+    };
+
+    //Owns a Java VM created from C++. Only one can exist per process and, since the VM
+    //cannot be recreated after it is destroyed, only once per process lifetime.
+    //The constructing thread stays attached and must be the one to destroy the host.
+    //
+    //Before the host is destroyed every other thread attached through smjni (e.g. java_thread_pool
+    //workers) must have exited, otherwise the process is terminated. Destruction releases all
+    //global references held by the library: the exception translator registry, java_completion,
+    //the installed exception dispatcher (which must itself be destroyed before the host),
+    //class tables and java_runtime.
+    class java_vm_host
+    {
+    public:
+        explicit java_vm_host(const java_vm_options & options);
+        ~java_vm_host() noexcept;
+
+        java_vm_host(const java_vm_host &) = delete;
+        java_vm_host & operator=(const java_vm_host &) = delete;
+
+        //Initializes class tables that are terminated, in reverse order, before the VM is destroyed
+        template<typename... ClassTable>
+        void init_classes(java_class_table_mode mode = java_class_table_mode::eager, unsigned thread_count = 0)
+        {
+            auto start = std::chrono::steady_clock::now();
+            (init_class_table<ClassTable>(mode, thread_count), ...);
+            m_timing.classes_init += std::chrono::steady_clock::now() - start;
+        }
+
+        JavaVM * vm() const noexcept
+            { return m_vm; }
+        //JNIEnv of the thread that created the host
+        JNIEnv * env() const noexcept
+            { return m_env; }
+
+        const java_vm_startup_timing & startup_timing() const noexcept
+            { return m_timing; }
+    private:
+        template<typename ClassTable>
+        void init_class_table(java_class_table_mode mode, unsigned thread_count)
+        {
+            m_class_tables.reserve(m_class_tables.size() + 1);
+            ClassTable::init(m_env, mode, thread_count);
+            m_class_tables.push_back(&ClassTable::term);
+        }
+
+        void destroy() noexcept;
+    private:
+        JavaVM * m_vm = nullptr;
+        JNIEnv * m_env = nullptr;
+        std::vector<void (*)()> m_class_tables;
+        java_vm_startup_timing m_timing;
+    };
+}
+
+#endif //HEADER_JAVA_VM_HOST_H_INCLUDED
@@ -20,17 +20,12 @@
 
 #include <jni.h>
 
-#include <memory>
+#include <cstddef>
 
 #include <smjni/config.h>
 
 namespace smjni
 {
-    namespace internal
-    {
-        class jni_record;
-    };
-
     class jni_provider
     {
     public:
@@ -39,8 +34,33 @@ namespace smjni
         
         static void init(JNIEnv * initialEnv);
         static void init(JavaVM * vm);
+        //Forgets the VM. Only needed when the process destroys a VM it created itself (see java_vm_host).
+        //Envs cached by other threads are not cleared so every thread that used smjni must have
+        //stopped before. Afterwards get_jni() throws on threads without a cached env.
+        static void term() noexcept;
+        
+        static JNIEnv * get_jni()
+        {
+            JNIEnv * ret = s_env;
+            if (!ret)
+                ret = attach_current_thread();
+            return ret;
+        }
+        
+        //Attaches current thread to the VM under a given name (unless it is already attached)
+        //The thread is automatically detached when it exits
+        SMJNI_NO_INLINE static JNIEnv * attach_current_thread(const char * name = nullptr);
+        
+        //Number of threads other than the calling one that were attached by attach_current_thread
+        //and have not exited yet
+        static size_t attached_threads() noexcept;
         
-        static JNIEnv * get_jni();
+        //Remembers the JNIEnv passed to a native method so that subsequent get_jni() calls
+        //on this thread do not need to query the VM. Only pass the env of the current thread.
+        static void seed(JNIEnv * env) noexcept
+        {
+            s_env = env;
+        }
         
         JavaVM * vm() const
             { return m_vm; }
@@ -51,7 +71,7 @@ namespace smjni
         ~jni_provider() = default;
     private:
         JavaVM * m_vm;
-        static thread_local std::unique_ptr<internal::jni_record> m_record;
+        SMJNI_TLS_MODEL static inline thread_local JNIEnv * s_env = nullptr;
     };
 }
 
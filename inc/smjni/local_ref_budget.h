@@ -0,0 +1,105 @@
+/*
+ Copyright 2019 SmJNI Contributors
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#ifndef HEADER_LOCAL_REF_BUDGET_H_INCLUDED
+#define HEADER_LOCAL_REF_BUDGET_H_INCLUDED
+
+#include <cstddef>
+
+#include <smjni/config.h>
+
+//Local reference accounting, off unless enabled. It changes inline function bodies and thread local
+//state so it must be the same for the library and every consumer: set it through the SMJNI_TRACK_LOCAL_REFS
+//CMake option, never per consumer or per build configuration
+#ifndef SMJNI_TRACK_LOCAL_REFS
+    #define SMJNI_TRACK_LOCAL_REFS 0
+#endif
+
+namespace smjni
+{
+    //Per thread (and so per JNIEnv) count of local references owned by local_java_ref objects
+    //
+    //Only references that pass through local_java_ref are seen. Raw references returned
+    //from JNI and never wrapped are not counted, and ones given up via release() stop being counted.
+    //java_frame resets the count to its value at the time the frame was pushed. The VM frees all
+    //local references of a native method when it returns, so native methods should declare a
+    //local_ref_budget::native_scope on entry to do the same for the count.
+    //When SMJNI_TRACK_LOCAL_REFS is 0 all of this compiles away.
+    class local_ref_budget
+    {
+    public:
+        local_ref_budget() = delete;
+
+        static constexpr bool enabled = SMJNI_TRACK_LOCAL_REFS != 0;
+
+        static size_t live() noexcept
+            { return s_live; }
+        static size_t high_water_mark() noexcept
+            { return s_high_water_mark; }
+        static void reset_high_water_mark() noexcept
+            { s_high_water_mark = s_live; }
+
+        static void on_created() noexcept
+        {
+            if constexpr (enabled)
+            {
+                if (++s_live > s_high_water_mark)
+                    s_high_water_mark = s_live;
+            }
+        }
+        static void on_deleted() noexcept
+        {
+            if constexpr (enabled)
+            {
+                if (s_live)
+                    --s_live;
+            }
+        }
+        static void restore(size_t live) noexcept
+        {
+            if constexpr (enabled)
+                s_live = live;
+        }
+        static void restore_high_water_mark(size_t value) noexcept
+        {
+            if constexpr (enabled)
+                s_high_water_mark = value;
+        }
+
+        //Restores the count on exit from a native method. Nested native calls are handled
+        //since each scope only undoes what happened while it was active
+        class native_scope
+        {
+        public:
+            native_scope() noexcept
+            {
+                if constexpr (enabled)
+                    m_live = s_live;
+            }
+            ~native_scope() noexcept
+                { restore(m_live); }
+            native_scope(const native_scope &) = delete;
+            native_scope & operator=(const native_scope &) = delete;
+        private:
+            size_t m_live = 0;
+        };
+    private:
+        SMJNI_TLS_MODEL static inline thread_local size_t s_live = 0;
+        SMJNI_TLS_MODEL static inline thread_local size_t s_high_water_mark = 0;
+    };
+}
+
+#endif //HEADER_LOCAL_REF_BUDGET_H_INCLUDED
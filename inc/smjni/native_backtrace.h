@@ -0,0 +1,118 @@
+/*
+ Copyright 2019 SmJNI Contributors
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#ifndef HEADER_NATIVE_BACKTRACE_H_INCLUDED
+#define HEADER_NATIVE_BACKTRACE_H_INCLUDED
+
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <smjni/config.h>
+
+namespace smjni
+{
+    //Return addresses of the native call stack captured when an exception was created
+    //
+    //Capture is off by default and controlled at runtime with set_enabled(). When off
+    //capture() is a single relaxed load. Capturing only records addresses, turning them
+    //into names is left to symbolize() which is meant to run away from the throwing thread.
+    //Exceptions hold their backtrace via capture_shared() so they only pay for it when enabled.
+    class native_backtrace
+    {
+    public:
+        static constexpr unsigned max_frames = 32;
+
+        struct frame
+        {
+            void * address;
+            //path of the containing module, empty if unknown
+            std::string module;
+            //demangled name of the nearest symbol, empty if unknown
+            std::string symbol;
+            //offset from the symbol if known, otherwise from the module base
+            uintptr_t offset;
+        };
+    public:
+        native_backtrace() noexcept = default;
+
+        static void set_enabled(bool enabled) noexcept
+            { s_enabled.store(enabled, std::memory_order_relaxed); }
+        static bool enabled() noexcept
+            { return s_enabled.load(std::memory_order_relaxed); }
+
+        //skip is the number of innermost frames to omit below the caller
+        SMJNI_FORCE_INLINE static native_backtrace capture(unsigned skip = 0) noexcept
+        {
+            native_backtrace ret;
+            if (enabled())
+                ret.do_capture(skip);
+            return ret;
+        }
+
+        //Same as capture() but heap allocated, null when disabled or out of memory
+        SMJNI_FORCE_INLINE static std::shared_ptr<const native_backtrace> capture_shared(unsigned skip = 0) noexcept
+        {
+            if (!enabled())
+                return nullptr;
+            return do_capture_shared(skip);
+        }
+
+        //The backtrace stored in an exception thrown by this library, if any
+        static const native_backtrace * of(const std::exception & ex) noexcept;
+
+        unsigned size() const noexcept
+            { return m_size; }
+        void * const * addresses() const noexcept
+            { return m_frames; }
+        explicit operator bool() const noexcept
+            { return m_size != 0; }
+
+        std::vector<frame> symbolize() const;
+        //Runs symbolize() on a separate thread
+        std::future<std::vector<frame>> symbolize_async() const;
+    private:
+        SMJNI_NO_INLINE void do_capture(unsigned skip) noexcept;
+        SMJNI_NO_INLINE static std::shared_ptr<const native_backtrace> do_capture_shared(unsigned skip) noexcept;
+    private:
+        void * m_frames[max_frames] = {};
+        unsigned m_size = 0;
+
+        static inline std::atomic<bool> s_enabled{false};
+    };
+
+    //What THROW_JAVA_PROBLEM throws unless overridden via set_externals
+    class java_problem : public std::runtime_error
+    {
+    public:
+        java_problem(const std::string & message, std::shared_ptr<const native_backtrace> backtrace):
+            std::runtime_error(message),
+            m_backtrace(std::move(backtrace))
+        {}
+
+        //null unless native_backtrace was enabled when the exception was created
+        const native_backtrace * backtrace() const noexcept
+            { return m_backtrace.get(); }
+    private:
+        std::shared_ptr<const native_backtrace> m_backtrace;
+    };
+}
+
+#endif //HEADER_NATIVE_BACKTRACE_H_INCLUDED
@@ -0,0 +1,147 @@
+/*
+ Copyright 2019 SmJNI Contributors
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#ifndef HEADER_NATIVE_PEER_H_INCLUDED
+#define HEADER_NATIVE_PEER_H_INCLUDED
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include <smjni/config.h>
+#include <smjni/java_field.h>
+
+namespace smjni
+{
+    namespace internal
+    {
+        //Maps handles to pointers. A handle is a slot index in the upper 32 bits and the
+        //slot's generation in the lower ones. Removing a pointer bumps the generation so
+        //stale handles no longer match. Lookups never lock, only add and remove do.
+        class native_peer_table
+        {
+        private:
+            struct slot
+            {
+                std::atomic<uint32_t> generation{1};
+                std::atomic<void *> ptr{nullptr};
+            };
+        public:
+            native_peer_table() noexcept = default;
+            ~native_peer_table() noexcept;
+            native_peer_table(const native_peer_table &) = delete;
+            native_peer_table & operator=(const native_peer_table &) = delete;
+
+            jlong add(void * ptr);
+            //Returns the removed pointer or null if the handle is stale
+            void * remove(jlong handle) noexcept;
+
+            SMJNI_FORCE_INLINE void * find(jlong handle) const noexcept
+            {
+                uint64_t value = uint64_t(handle);
+                uint32_t index = uint32_t(value >> 32);
+                uint32_t generation = uint32_t(value);
+                if (index >= s_max_chunks * s_chunk_size)
+                    return nullptr;
+                slot * chunk = m_chunks[index >> s_chunk_bits].load(std::memory_order_acquire);
+                if (!chunk)
+                    return nullptr;
+                const slot & entry = chunk[index & (s_chunk_size - 1)];
+                //the pointer must be read first: if it belongs to a newer owner the generation has already moved on
+                void * ret = entry.ptr.load(std::memory_order_acquire);
+                if (entry.generation.load(std::memory_order_acquire) != generation)
+                    return nullptr;
+                return ret;
+            }
+
+            [[noreturn]] static void throw_dangling(const char * name);
+        private:
+            static constexpr unsigned s_chunk_bits = 10;
+            static constexpr uint32_t s_chunk_size = 1 << s_chunk_bits;
+            static constexpr uint32_t s_max_chunks = 1024;
+
+            std::atomic<slot *> m_chunks[s_max_chunks] = {};
+            std::mutex m_mutex;
+            std::vector<uint32_t> m_free;
+            uint32_t m_used = 0;
+        };
+    }
+
+    //Binds C++ objects to Java objects through a long field of the Java object
+    //
+    //The field holds a generation checked handle rather than a raw pointer so a handle
+    //that outlives its C++ object is detected instead of dereferenced. Ownership of the
+    //C++ object stays with the caller: detach it before destroying it.
+    template<typename T, typename JavaType>
+    class native_peer
+    {
+    public:
+        native_peer() = default;
+        native_peer(JNIEnv * jenv, const java_class<JavaType> & clazz, const char * name):
+            m_field(jenv, clazz, name),
+            m_name(name)
+        {}
+
+        //Throws if the object has no attached peer or the peer has been detached
+        SMJNI_FORCE_INLINE T & get(JNIEnv * jenv, const auto_java_ref<JavaType> & object) const
+        {
+            T * ret = find(jenv, object);
+            if (!ret)
+                internal::native_peer_table::throw_dangling(m_name);
+            return *ret;
+        }
+
+        SMJNI_FORCE_INLINE T * find(JNIEnv * jenv, const auto_java_ref<JavaType> & object) const
+        {
+            return static_cast<T *>(s_table.find(m_field.get(jenv, object)));
+        }
+
+        //Replaces any previously attached peer and returns it, or null if there was none.
+        //The previous peer is not destroyed so the caller must take care of it
+        [[nodiscard]] T * attach(JNIEnv * jenv, const auto_java_ref<JavaType> & object, T * peer) const
+        {
+            jlong handle = s_table.add(peer);
+            try
+            {
+                jlong previous = m_field.get(jenv, object);
+                m_field.set(jenv, object, handle);
+                return static_cast<T *>(s_table.remove(previous));
+            }
+            catch(...)
+            {
+                s_table.remove(handle);
+                throw;
+            }
+        }
+
+        //Returns the detached peer or null if there was none
+        T * detach(JNIEnv * jenv, const auto_java_ref<JavaType> & object) const
+        {
+            jlong handle = m_field.get(jenv, object);
+            m_field.set(jenv, object, 0);
+            return static_cast<T *>(s_table.remove(handle));
+        }
+
+    private:
+        java_field<jlong, JavaType> m_field;
+        const char * m_name = nullptr;
+
+        static inline internal::native_peer_table s_table;
+    };
+}
+
+#endif //HEADER_NATIVE_PEER_H_INCLUDED
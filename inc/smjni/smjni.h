@@ -21,17 +21,32 @@
 #include <smjni/java_types.h>
 #include <smjni/jni_provider.h>
 #include <smjni/java_ref.h>
+#include <smjni/global_ref_pool.h>
+#include <smjni/local_ref_budget.h>
 #include <smjni/java_type_traits.h>
+#include <smjni/java_call_stats.h>
 #include <smjni/java_method.h>
 #include <smjni/java_field.h>
+#include <smjni/java_id_slot.h>
 #include <smjni/java_class.h>
+#include <smjni/native_backtrace.h>
 #include <smjni/java_exception.h>
+#include <smjni/java_exception_dispatcher.h>
+#include <smjni/java_exception_translator.h>
 #include <smjni/java_array.h>
 #include <smjni/java_string.h>
 #include <smjni/java_direct_buffer.h>
 #include <smjni/java_frame.h>
 #include <smjni/java_runtime.h>
 #include <smjni/java_class_table.h>
+#include <smjni/java_field_snapshot.h>
+#include <smjni/java_native_registry.h>
+#include <smjni/java_thread_pool.h>
+#include <smjni/java_future.h>
+#include <smjni/java_event_batcher.h>
+#include <smjni/java_vm_host.h>
+#include <smjni/weak_object_cache.h>
+#include <smjni/native_peer.h>
 #include <smjni/java_externals.h>
 
 #endif 
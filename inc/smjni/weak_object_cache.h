@@ -0,0 +1,192 @@
+/*
+ Copyright 2019 SmJNI Contributors
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#ifndef HEADER_WEAK_OBJECT_CACHE_H_INCLUDED
+#define HEADER_WEAK_OBJECT_CACHE_H_INCLUDED
+
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <smjni/java_ref.h>
+#include <smjni/java_cast.h>
+
+namespace smjni
+{
+    //Maps C++ keys to Java objects without keeping the objects alive
+    //
+    //Lookups promote the weak reference to a local one. Entries whose object has been
+    //collected are dropped when found by a lookup and also purged incrementally:
+    //every lookup and insertion probes a couple of other entries so the cost is amortized
+    //and the cache never needs a full sweep.
+    template<typename Key, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+    class weak_object_cache
+    {
+    private:
+        struct entry
+        {
+            Key key;
+            weak_java_ref<jobject> ref;
+        };
+    public:
+        struct statistics
+        {
+            size_t hits = 0;
+            //lookups that found an entry whose object was already collected
+            size_t dead = 0;
+            size_t misses = 0;
+            //dead entries removed by incremental purging
+            size_t purged = 0;
+        };
+    public:
+        weak_object_cache() = default;
+        weak_object_cache(const weak_object_cache &) = delete;
+        weak_object_cache & operator=(const weak_object_cache &) = delete;
+
+        //Replaces any existing entry for the key
+        void put(JNIEnv * env, const Key & key, const auto_java_ref<jobject> & obj)
+        {
+            weak_java_ref<jobject> ref(obj);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_index.find(key);
+            if (it != m_index.end())
+            {
+                m_entries[it->second].ref = std::move(ref);
+            }
+            else
+            {
+                m_entries.push_back(entry{key, std::move(ref)});
+                try
+                {
+                    m_index.emplace(key, m_entries.size() - 1);
+                }
+                catch(...)
+                {
+                    m_entries.pop_back();
+                    throw;
+                }
+            }
+            purge_step(env);
+        }
+
+        //Returns null if there is no entry for the key or its object has been collected
+        template<typename T = jobject>
+        unique_local_ref<T> get(JNIEnv * env, const Key & key)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            unique_local_ref<T> ret;
+            auto it = m_index.find(key);
+            if (it == m_index.end())
+            {
+                ++m_stats.misses;
+            }
+            else
+            {
+                ret = unique_local_ref<T>(jattach(env, jstatic_cast<T>(env->NewLocalRef(m_entries[it->second].ref.c_ptr()))));
+                if (ret)
+                {
+                    ++m_stats.hits;
+                }
+                else
+                {
+                    ++m_stats.dead;
+                    remove(it->second);
+                }
+            }
+            purge_step(env);
+            return ret;
+        }
+
+        bool erase(const Key & key)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_index.find(key);
+            if (it == m_index.end())
+                return false;
+            remove(it->second);
+            return true;
+        }
+
+        void clear()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_index.clear();
+            m_entries.clear();
+            m_purge_pos = 0;
+        }
+
+        //Number of entries including ones whose objects are dead but not yet purged
+        size_t size() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_entries.size();
+        }
+
+        statistics get_statistics() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_stats;
+        }
+        void reset_statistics()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stats = statistics();
+        }
+    private:
+        void purge_step(JNIEnv * env) noexcept
+        {
+            for (unsigned i = 0; i < s_purge_step && !m_entries.empty(); ++i)
+            {
+                if (m_purge_pos >= m_entries.size())
+                    m_purge_pos = 0;
+                //a cleared weak reference compares equal to null without creating a local reference
+                if (env->IsSameObject(m_entries[m_purge_pos].ref.c_ptr(), nullptr))
+                {
+                    ++m_stats.purged;
+                    remove(m_purge_pos);
+                }
+                else
+                {
+                    ++m_purge_pos;
+                }
+            }
+        }
+
+        //swaps the last entry into the removed slot to keep entries dense
+        void remove(size_t pos) noexcept
+        {
+            m_index.erase(m_entries[pos].key);
+            size_t last = m_entries.size() - 1;
+            if (pos != last)
+            {
+                m_entries[pos] = std::move(m_entries[last]);
+                m_index.find(m_entries[pos].key)->second = pos;
+            }
+            m_entries.pop_back();
+        }
+    private:
+        static constexpr unsigned s_purge_step = 2;
+
+        mutable std::mutex m_mutex;
+        std::vector<entry> m_entries;
+        std::unordered_map<Key, size_t, Hash, KeyEqual> m_index;
+        size_t m_purge_pos = 0;
+        statistics m_stats;
+    };
+}
+
+#endif //HEADER_WEAK_OBJECT_CACHE_H_INCLUDED
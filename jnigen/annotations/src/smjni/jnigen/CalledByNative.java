@@ -46,4 +46,15 @@ public @interface CalledByNative
      * This has no effect of constructors, fields and static methods
      */
     boolean allowNonVirtualCall() default false;
+
+    /**
+     * Use a {@code long} field as the handle of a native peer object
+     *
+     * If set to a C++ type name JniGen exposes the field as
+     * {@code smjni::native_peer} of that type instead of a plain field,
+     * with get, attach and detach accessors. The C++ type must be declared
+     * before the generated headers are included.
+     * This has no effect on methods and constructors
+     */
+    String nativePeer() default "";
 }
\ No newline at end of file
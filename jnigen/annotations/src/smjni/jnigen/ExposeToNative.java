@@ -72,4 +72,36 @@ public @interface ExposeToNative {
      * The default is JavaTypeName_class.h or if {@link #value()} is set {$value}_class.h
      */
     String header() default "";
+
+    /**
+     * Whether to resolve method and field IDs on first use
+     *
+     * By default the generated C++ class looks up all its method and field IDs
+     * when it is constructed. If this argument is set to true each ID is instead
+     * looked up the first time the corresponding member is called. This reduces
+     * startup cost for classes with many members of which only a few are used.
+     */
+    boolean lazy() default false;
+
+    /**
+     * Whether to generate free inline functions for the members called by native code
+     *
+     * If set to true, JniGen additionally generates a namespace named after the C++ class
+     * with a suffix {@code _inline} (e.g. {@code Foo_class_inline}) holding a free function
+     * for each member. Their method and field IDs live in constant initialized variables filled
+     * when the C++ class is constructed, which class table initialization always does, so a call
+     * needs neither the class table nor a class instance. Class members forward to these functions. Calls made this way are not
+     * counted by call statistics. Cannot be combined with {@link #lazy()}.
+     */
+    boolean inlineAccessors() default false;
+
+    /**
+     * Whether to generate bulk snapshot accessors for primitive fields
+     *
+     * If set to true, non-static primitive fields annotated with {@link CalledByNative}
+     * can additionally be read and written all at once with a single call into Java
+     * through a generated C++ {@code snapshot} struct. JniGen generates a package-private
+     * Java helper class for this, so such fields must not be private.
+     */
+    boolean snapshot() default false;
 }
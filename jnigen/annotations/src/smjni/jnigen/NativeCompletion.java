@@ -0,0 +1,47 @@
+/*
+ Copyright 2019 SmJNI Contributors
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+package smjni.jnigen;
+
+import java.util.function.BiConsumer;
+
+/**
+ * Completion callback used by native code to await a {@code CompletableFuture}
+ *
+ * Instances are created by SmJNI's {@code smjni::java_completion} and
+ * passed to {@code whenComplete}. The native side is notified exactly once
+ * when the future completes. If the future is dropped without completing
+ * the native callback is never released.
+ * This class must be visible to the class loader that initializes
+ * {@code smjni::java_completion}.
+ */
+public final class NativeCompletion implements BiConsumer<Object, Throwable>
+{
+    private final long handle;
+
+    NativeCompletion(long handle)
+    {
+        this.handle = handle;
+    }
+
+    @Override
+    public void accept(Object result, Throwable error)
+    {
+        complete(handle, result, error);
+    }
+
+    private static native void complete(long handle, Object result, Throwable error);
+}
@@ -22,6 +22,7 @@ import javax.lang.model.type.TypeKind
 import javax.lang.model.type.TypeMirror
 
 internal class NativeMethod(val isStatic: Boolean,
+                            val isCritical: Boolean,
                             var isNameNonUnique: Boolean,
                             val returnType: String,
                             val name: CharSequence,
@@ -32,9 +33,22 @@ internal enum class JavaEntityType {
     Method,
     StaticMethod,
     Field,
-    StaticField
+    StaticField,
+    NativePeer
 }
 
+internal class SnapshotField(val name: String,
+                             val nativeType: String,
+                             val kind: TypeKind,
+                             val isFinal: Boolean)
+
+internal class Snapshot(val name: UniqueName,
+                        val bufferName: UniqueName,
+                        val javaHelperName: String,
+                        val cppHelperType: String,
+                        val selfType: String,
+                        val fields: List<SnapshotField>)
+
 internal class JavaEntity(val type: JavaEntityType,
                           val isFinal: Boolean,
                           val allowNonVirt: Boolean,
@@ -47,14 +61,21 @@ internal class JavaEntity(val type: JavaEntityType,
 internal class ClassContent(val classElement: TypeElement,
                             val binaryName: String,
                             val cppClassName: String,
+                            val lazyMembers: Boolean,
+                            snapshot: Boolean,
+                            val inlineAccessors: Boolean,
                             val convertsTo: Set<String>,
                             typeMap: TypeMap,
                             ctxt: Context) {
 
     private val m_nativeMethods = ArrayList<NativeMethod>()
     private val m_javaEntities = ArrayList<JavaEntity>()
+    private val m_snapshotFields = ArrayList<SnapshotField>()
+    private var m_snapshot: Snapshot? = null
+    private var m_idsName: UniqueName? = null
 
     private val CALLED_BY_NATIVE = ctxt.calledByNativeAnnotation
+    private val CRITICAL_NATIVE = ctxt.criticalNativeAnnotation
     private val CTOR_NAME = ctxt.ctorName
 
     internal val cppName = typeMap.nativeNameOf(classElement.qualifiedName)
@@ -96,11 +117,26 @@ internal class ClassContent(val classElement: TypeElement,
 
                         val fieldElement = childElement as VariableElement
 
-                        if (childElement.annotationMirrors.any {
-                                    val annotationType = it.annotationType.asElement() as TypeElement
-                                    annotationType.qualifiedName.contentEquals(CALLED_BY_NATIVE)
-                                }) {
-                            addJavaField(fieldElement, names, typeMap)
+                        val annotation = childElement.annotationMirrors.find {
+                            val annotationType = it.annotationType.asElement() as TypeElement
+                            annotationType.qualifiedName.contentEquals(CALLED_BY_NATIVE)
+                        }
+                        if (annotation != null) {
+                            var nativePeer = ""
+                            for ((name, value) in ctxt.elementUtils.getElementValuesWithDefaults(annotation)) {
+
+                                when {
+                                    name.simpleName.contentEquals("nativePeer") -> nativePeer = value.value as String
+                                }
+                            }
+
+                            if (nativePeer.isEmpty()) {
+                                addJavaField(fieldElement, names, typeMap)
+                                if (snapshot)
+                                    addSnapshotField(fieldElement, typeMap)
+                            }
+                            else
+                                addNativePeer(fieldElement, nativePeer, names, typeMap)
                         }
                     }
                     ElementKind.CONSTRUCTOR -> {
@@ -123,6 +159,25 @@ internal class ClassContent(val classElement: TypeElement,
             }
         }
 
+        //namespace of the ID slots used by inline accessors, must not clash with their names
+        if (inlineAccessors)
+            m_idsName = names.allocateName("ids")
+
+        if (m_snapshotFields.isNotEmpty()) {
+            if (classElement.modifiers.contains(Modifier.PRIVATE))
+                throw ProcessingException("class with snapshot fields must not be private", classElement)
+
+            //the helper lives in the same package so that it can access non-private fields
+            val packageName = ctxt.elementUtils.getPackageOf(classElement).qualifiedName.toString()
+            val helperName = (if (packageName.isNotEmpty()) binaryName.removePrefix("$packageName.") else binaryName)
+                                .replace('$', '_') + "_JniGenSnapshot"
+            m_snapshot = Snapshot(names.allocateName("snapshot"),
+                                  names.allocateName("snapshot_buffer"),
+                                  if (packageName.isNotEmpty()) "$packageName.$helperName" else helperName,
+                                  "${cppName}_snapshot",
+                                  typeMap.wrapperNameOf(classElement.asType(), true),
+                                  m_snapshotFields)
+        }
     }
 
     internal val nativeMethods: List<NativeMethod>
@@ -131,6 +186,12 @@ internal class ClassContent(val classElement: TypeElement,
     internal val javaEntities: List<JavaEntity>
         get() = m_javaEntities
 
+    internal val snapshot: Snapshot?
+        get() = m_snapshot
+
+    internal val idsName: UniqueName?
+        get() = m_idsName
+
     internal val hasCppClass: Boolean
         get() = javaEntities.isNotEmpty() || nativeMethods.isNotEmpty()
 
@@ -145,6 +206,15 @@ internal class ClassContent(val classElement: TypeElement,
 
 
         val isStatic = methodElement.modifiers.contains(Modifier.STATIC)
+        val isCritical = methodElement.annotationMirrors.any {
+            val annotationType = it.annotationType.asElement() as TypeElement
+            annotationType.qualifiedName.contentEquals(CRITICAL_NATIVE)
+        }
+        if (isCritical) {
+            if (!isStatic || !isPrimitiveReturnType(methodElement.returnType) ||
+                    methodElement.parameters.any { !it.asType().kind.isPrimitive })
+                throw ProcessingException("critical native method must be static and use only primitive types", methodElement)
+        }
         val returnType = typeMap.nativeNameOf(methodElement.returnType)
         val methodName = methodElement.simpleName
         val previousNameUser = previousNameUsers[methodName]
@@ -156,15 +226,17 @@ internal class ClassContent(val classElement: TypeElement,
             isNameNonUnique = false
         }
         val arguments = ArrayList<Pair<String, String?>>()
-        arguments.add(Pair("JNIEnv *", null))
-        if (isStatic)
-            arguments.add(Pair("jclass", null))
-        else
-            arguments.add(Pair("$cppName", null))
+        if (!isCritical) {
+            arguments.add(Pair("JNIEnv *", null))
+            if (isStatic)
+                arguments.add(Pair("jclass", null))
+            else
+                arguments.add(Pair("$cppName", null))
+        }
         methodElement.parameters.mapTo(arguments) {
             Pair(typeMap.nativeNameOf(it.asType()), it.simpleName.toString())
         }
-        val method = NativeMethod(isStatic, isNameNonUnique, returnType, methodName, arguments)
+        val method = NativeMethod(isStatic, isCritical, isNameNonUnique, returnType, methodName, arguments)
         m_nativeMethods.add(method)
         previousNameUsers[methodName] = method
     }
@@ -229,6 +301,34 @@ internal class ClassContent(val classElement: TypeElement,
         m_javaEntities.add(field)
     }
 
+    private fun addSnapshotField(fieldElement: VariableElement, typeMap: TypeMap) {
+
+        val fieldType = fieldElement.asType()
+        if (fieldElement.modifiers.contains(Modifier.STATIC) || !fieldType.kind.isPrimitive)
+            return
+        if (fieldElement.modifiers.contains(Modifier.PRIVATE))
+            throw ProcessingException("snapshot field must not be private", fieldElement)
+
+        m_snapshotFields.add(SnapshotField(fieldElement.simpleName.toString(), typeMap.nativeNameOf(fieldType),
+                                           fieldType.kind, fieldElement.modifiers.contains(Modifier.FINAL)))
+    }
+
+    private fun addNativePeer(fieldElement: VariableElement, peerType: String, names: NameTable, typeMap: TypeMap) {
+
+        if (fieldElement.modifiers.contains(Modifier.STATIC) || fieldElement.asType().kind != TypeKind.LONG)
+            throw ProcessingException("native peer field must be a non-static long", fieldElement)
+
+        val fieldName = names.allocateName(fieldElement.simpleName.toString())
+
+        val templateArguments = listOf(peerType, "$cppName")
+        val argTypes = listOf(typeMap.wrapperNameOf(classElement.asType(), true))
+        val argNames = listOf("self")
+
+        val peer = JavaEntity(JavaEntityType.NativePeer, false, false,
+                fieldName, templateArguments, "$peerType &", argTypes, argNames)
+        m_javaEntities.add(peer)
+    }
+
     private fun addJavaConstructor(constructorElement: ExecutableElement, names: NameTable, typeMap: TypeMap) {
 
         val name = names.allocateName(CTOR_NAME)
@@ -238,7 +338,7 @@ internal class ClassContent(val classElement: TypeElement,
         val argNames = ArrayList<String>()
 
         templateArguments.add("$cppName")
-        val returnType = "smjni::local_java_ref<$cppName>"
+        val returnType = "smjni::unique_local_ref<$cppName>"
         for (param in constructorElement.parameters) {
             val paramType = param.asType()
             templateArguments.add(typeMap.nativeNameOf(paramType))
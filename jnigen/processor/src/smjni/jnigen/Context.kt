@@ -31,6 +31,8 @@ internal class Context(env: ProcessingEnvironment) {
         OUTPUT_LIST_NAME("smjni.jnigen.output.list.name", "outputs.txt"),
         EXPOSE_ANNOTATION_NAME("smjni.jnigen.expose.annotation.name", "smjni.jnigen.ExposeToNative"),
         CALLED_ANNOTATION_NAME("smjni.jnigen.called.annotation.name", "smjni.jnigen.CalledByNative"),
+        //native methods with this annotation are implemented without JNIEnv and jclass
+        CRITICAL_ANNOTATION_NAME("smjni.jnigen.critical.annotation.name", "dalvik.annotation.optimization.CriticalNative"),
         CTOR_NAME("smjni.jnigen.ctor.name", "ctor");
 
         fun extract(env: ProcessingEnvironment): String {
@@ -42,6 +44,7 @@ internal class Context(env: ProcessingEnvironment) {
     //val typeUtils = env.typeUtils!!
     val elementUtils = env.elementUtils!!
     val messager = env.messager!!
+    val filer = env.filer!!
     val destPath: String = File(Options.DEST_PATH.extract(env)).absolutePath
     val exposeExtra: Map<String, String>
     val headerName = Options.TYPE_HEADER_NAME.extract(env)
@@ -49,6 +52,7 @@ internal class Context(env: ProcessingEnvironment) {
     val outputListName = Options.OUTPUT_LIST_NAME.extract(env)
     val exposedAnnotation = Options.EXPOSE_ANNOTATION_NAME.extract(env)
     val calledByNativeAnnotation = Options.CALLED_ANNOTATION_NAME.extract(env)
+    val criticalNativeAnnotation = Options.CRITICAL_ANNOTATION_NAME.extract(env)
     val ctorName = Options.CTOR_NAME.extract(env)
 
     init {
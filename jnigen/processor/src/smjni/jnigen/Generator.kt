@@ -24,6 +24,7 @@ import java.nio.file.Paths
 import java.nio.file.Files
 import java.security.MessageDigest
 import java.nio.file.StandardCopyOption
+import javax.lang.model.type.TypeKind
 
 
 internal class Generator {
@@ -40,6 +41,9 @@ internal class Generator {
 
         generateAllClassesHeader(allHeaders, typeMap, context)
         generateOutputsList(allHeaders, context)
+
+        for (classContent in typeMap.exposedClasses.values)
+            generateSnapshotHelper(classContent, context)
     }
 
     private fun generateTypeHeader(typeMap: TypeMap, context: Context) {
@@ -59,6 +63,9 @@ internal class Generator {
 
             for (classContent in exposedClasses) {
                 typeHeader.write("DEFINE_JAVA_TYPE(${classContent.cppName},  \"${classContent.binaryName}\")\n")
+                val snapshot = classContent.snapshot
+                if (snapshot != null)
+                    typeHeader.write("DEFINE_JAVA_TYPE(${snapshot.cppHelperType},  \"${snapshot.javaHelperName}\")\n")
             }
             typeHeader.write("\n")
 
@@ -112,28 +119,129 @@ internal class Generator {
 
     private fun generateClassDef(classHeader: FileWriter, content: ClassContent)  {
 
+        if (content.inlineAccessors)
+            generateInlineAccessors(classHeader, content)
+
         classHeader.write("class ${content.cppClassName} : public smjni::java_runtime::simple_java_class<${content.cppName}>\n" +
                 "{\n" +
                 "public:\n" +
                 "    ${content.cppClassName}(JNIEnv * env);\n\n")
 
-        if (content.nativeMethods.isNotEmpty())
+        //makes java_class_table construct the class in init() regardless of mode so that the id slots are filled
+        if (content.inlineAccessors)
+            classHeader.write("    static constexpr bool inline_accessors = true;\n\n")
+
+        if (content.nativeMethods.isNotEmpty()) {
             classHeader.write("    void register_methods(JNIEnv * env) const;\n\n")
+            classHeader.write("    static const JNINativeMethod native_methods[];\n\n")
+        }
 
-        generateJavaEntityAccessors(content.javaEntities, classHeader)
+        generateJavaEntityAccessors(content.javaEntities, inlineNamespaceOf(content), classHeader)
+        generateSnapshotAccessors(content.snapshot, classHeader)
 
         classHeader.write("private:\n")
         generateNativeMethodDeclarations(content.nativeMethods, classHeader)
-        generateJavaEntityFields(content.javaEntities, classHeader)
+        generateJavaEntityFields(if (content.inlineAccessors) content.javaEntities.filter { it.type == JavaEntityType.NativePeer }
+                                 else content.javaEntities,
+                                 content.lazyMembers, classHeader)
+        generateSnapshotField(content, classHeader)
 
         classHeader.write("};\n\n\n")
 
         generateConstructorImplementation(content, classHeader)
 
         generateRegistrationMethodImplementation(content, classHeader)
+
+        generateSnapshotImplementation(content, classHeader)
+    }
+
+    private fun inlineNamespaceOf(content: ClassContent) : String? {
+
+        return if (content.inlineAccessors) "${content.cppClassName}_inline" else null
     }
 
-    private fun generateJavaEntityAccessors(javaEntities: List<JavaEntity>, classHeader: FileWriter) {
+    //Free functions calling through constant initialized id slots that the class constructor fills
+    private fun generateInlineAccessors(classHeader: FileWriter, content: ClassContent) {
+
+        val ids = content.idsName!!
+        val publishedClass = "smjni::java_class<${content.cppName}>::published()"
+
+        classHeader.write("namespace ${inlineNamespaceOf(content)}\n{\n")
+        classHeader.write("    namespace $ids\n    {\n")
+        for (javaEntity in content.javaEntities) {
+            when (javaEntity.type) {
+                JavaEntityType.Field, JavaEntityType.StaticField ->
+                    classHeader.write("        inline smjni::java_id_slot<jfieldID> ${javaEntity.name};\n")
+                JavaEntityType.NativePeer -> {}
+                else ->
+                    classHeader.write("        inline smjni::java_id_slot<jmethodID> ${javaEntity.name};\n")
+            }
+        }
+        classHeader.write("    }\n\n")
+
+        for (javaEntity in content.javaEntities) {
+
+            val argNameTable = NameTable()
+            val argNames = ArrayList<UniqueName>()
+            argNames.add(argNameTable.allocateName("env"))
+            if (javaEntity.allowNonVirt)
+                argNameTable.allocateName("classForNonVirtualCall")
+            javaEntity.argNames.mapTo(argNames) { argNameTable.allocateName(it) }
+
+            val id = "$ids::${javaEntity.name}.get()"
+            val returnPrefix = if (javaEntity.returnType != "void") "return " else ""
+
+            when (javaEntity.type) {
+                JavaEntityType.Method, JavaEntityType.StaticMethod, JavaEntityType.Constructor -> {
+
+                    val params = (0 until javaEntity.argTypes.size).joinToString(separator = "") { ", ${javaEntity.argTypes[it]} ${argNames[it + 1]}" }
+                    val args = (0 until javaEntity.argTypes.size).joinToString(separator = "") { ", ${argNames[it + 1]}" }
+
+                    classHeader.write("    inline ${javaEntity.returnType} ${javaEntity.name}(JNIEnv * env$params)\n        { $returnPrefix")
+                    when (javaEntity.type) {
+                        JavaEntityType.Method ->
+                            classHeader.write("smjni::internal::call_java_method<${javaEntity.templateArguments.joinToString(separator = ", ")}>(env, $id$args); }\n")
+                        JavaEntityType.StaticMethod ->
+                            classHeader.write("smjni::internal::call_java_static_method<${javaEntity.templateArguments.filterIndexed { i, _ -> i != 1 }.joinToString(separator = ", ")}>(env, $id, $publishedClass$args); }\n")
+                        else ->
+                            classHeader.write("smjni::internal::call_java_constructor<${javaEntity.templateArguments.joinToString(separator = ", ")}>(env, $id, $publishedClass$args); }\n")
+                    }
+
+                    if (javaEntity.allowNonVirt) {
+                        val restParams = (1 until javaEntity.argTypes.size).joinToString(separator = "") { ", ${javaEntity.argTypes[it]} ${argNames[it + 1]}" }
+                        val restArgs = (1 until javaEntity.argTypes.size).joinToString(separator = "") { ", ${argNames[it + 1]}" }
+                        classHeader.write("    template<typename ClassType> ${javaEntity.returnType} ${javaEntity.name}(JNIEnv * env" +
+                                ", ${javaEntity.argTypes[0]} ${argNames[1]}, const smjni::java_class<ClassType> & classForNonVirtualCall$restParams)\n" +
+                                "        { ${returnPrefix}smjni::internal::call_java_non_virtual_method<${javaEntity.templateArguments.joinToString(separator = ", ")}>(" +
+                                "env, $id, ${argNames[1]}, classForNonVirtualCall.c_ptr()$restArgs); }\n")
+                    }
+                }
+                JavaEntityType.Field -> {
+
+                    val typeArgs = javaEntity.templateArguments.joinToString(separator = ", ")
+                    val selfArg = "${javaEntity.argTypes[0]} ${argNames[1]}"
+                    classHeader.write("    inline ${javaEntity.returnType} get_${javaEntity.name}(JNIEnv * env, $selfArg)\n" +
+                            "        { return smjni::internal::get_java_field<$typeArgs>(env, $id, ${argNames[1]}); }\n")
+                    if (!javaEntity.isFinal)
+                        classHeader.write("    inline void set_${javaEntity.name}(JNIEnv * env, $selfArg, ${javaEntity.argTypes[1]} value)\n" +
+                                "        { smjni::internal::set_java_field<$typeArgs>(env, $id, ${argNames[1]}, value); }\n")
+                }
+                JavaEntityType.StaticField -> {
+
+                    val type = javaEntity.templateArguments[0]
+                    classHeader.write("    inline ${javaEntity.returnType} get_${javaEntity.name}(JNIEnv * env)\n" +
+                            "        { return smjni::internal::get_java_static_field<$type>(env, $id, $publishedClass); }\n")
+                    if (!javaEntity.isFinal)
+                        classHeader.write("    inline void set_${javaEntity.name}(JNIEnv * env, ${javaEntity.argTypes[0]} value)\n" +
+                                "        { smjni::internal::set_java_static_field<$type>(env, $id, $publishedClass, value); }\n")
+                }
+                JavaEntityType.NativePeer -> {}
+            }
+        }
+        classHeader.write("}\n\n")
+    }
+
+    private fun generateJavaEntityAccessors(javaEntities: List<JavaEntity>, inlineNamespace: String?, classHeader: FileWriter) {
 
         for(javaEntity in javaEntities) {
 
@@ -154,9 +262,13 @@ internal class Generator {
                     classHeader.write(") const\n        { ")
                     if (javaEntity.returnType != "void")
                         classHeader.write("return ")
-                    classHeader.write("$memberName(env")
-                    if (javaEntity.type == JavaEntityType.StaticMethod ||  javaEntity.type == JavaEntityType.Constructor)
-                        classHeader.write(", *this")
+                    if (inlineNamespace != null) {
+                        classHeader.write("$inlineNamespace::${javaEntity.name}(env")
+                    } else {
+                        classHeader.write("$memberName(env")
+                        if (javaEntity.type == JavaEntityType.StaticMethod ||  javaEntity.type == JavaEntityType.Constructor)
+                            classHeader.write(", *this")
+                    }
                     for (i in 0 until javaEntity.argTypes.size) {
                         classHeader.write(", ${argNames[i + 1]}")
                     }
@@ -172,7 +284,10 @@ internal class Generator {
                         classHeader.write(") const\n        { ")
                         if (javaEntity.returnType != "void")
                             classHeader.write("return ")
-                        classHeader.write("$memberName.call_non_virtual(env")
+                        if (inlineNamespace != null)
+                            classHeader.write("$inlineNamespace::${javaEntity.name}(env")
+                        else
+                            classHeader.write("$memberName.call_non_virtual(env")
                         classHeader.write(", ${argNames[1]}, classForNonVirtualCall")
                         for (i in 1 until javaEntity.argTypes.size) {
                             classHeader.write(", ${argNames[i + 1]}")
@@ -189,9 +304,13 @@ internal class Generator {
                     if (javaEntity.argTypes.size == 2) {
                         classHeader.write(", ${javaEntity.argTypes[0]} ${argNames[1]}")
                     }
-                    classHeader.write(") const\n        { return $memberName.get(env")
-                    if (javaEntity.type == JavaEntityType.StaticField)
-                        classHeader.write(", *this")
+                    if (inlineNamespace != null) {
+                        classHeader.write(") const\n        { return $inlineNamespace::$getter(env")
+                    } else {
+                        classHeader.write(") const\n        { return $memberName.get(env")
+                        if (javaEntity.type == JavaEntityType.StaticField)
+                            classHeader.write(", *this")
+                    }
                     if (javaEntity.argTypes.size == 2) {
                         classHeader.write(", ${argNames[1]}")
                     }
@@ -206,31 +325,50 @@ internal class Generator {
                         } else {
                             classHeader.write(", ${javaEntity.argTypes[0]} value")
                         }
-                        classHeader.write(") const\n        { $memberName.set(env")
-                        if (javaEntity.type == JavaEntityType.StaticField)
-                            classHeader.write(", *this")
+                        if (inlineNamespace != null) {
+                            classHeader.write(") const\n        { $inlineNamespace::$setter(env")
+                        } else {
+                            classHeader.write(") const\n        { $memberName.set(env")
+                            if (javaEntity.type == JavaEntityType.StaticField)
+                                classHeader.write(", *this")
+                        }
                         if (javaEntity.argTypes.size == 2) {
                             classHeader.write(", ${argNames[1]}")
                         }
                         classHeader.write(", value); }\n")
                     }
                 }
+                JavaEntityType.NativePeer -> {
+
+                    val memberName = "m_${javaEntity.name}"
+                    val peerType = javaEntity.templateArguments[0]
+                    val selfArg = "${javaEntity.argTypes[0]} ${argNames[1]}"
+
+                    classHeader.write("    ${javaEntity.returnType} get_${javaEntity.name}(JNIEnv * env, $selfArg) const\n" +
+                            "        { return $memberName.get(env, ${argNames[1]}); }\n")
+                    classHeader.write("    [[nodiscard]] $peerType * attach_${javaEntity.name}(JNIEnv * env, $selfArg, $peerType * value) const\n" +
+                            "        { return $memberName.attach(env, ${argNames[1]}, value); }\n")
+                    classHeader.write("    $peerType * detach_${javaEntity.name}(JNIEnv * env, $selfArg) const\n" +
+                            "        { return $memberName.detach(env, ${argNames[1]}); }\n")
+                }
             }
 
         }
     }
 
-    private fun generateJavaEntityFields(javaEntities: List<JavaEntity>, classHeader: FileWriter) {
+    private fun generateJavaEntityFields(javaEntities: List<JavaEntity>, lazy: Boolean, classHeader: FileWriter) {
 
         if (javaEntities.isNotEmpty()) {
+            val prefix = if (lazy) "java_lazy_" else "java_"
             for (javaEntity in javaEntities) {
 
                 when (javaEntity.type) {
-                    JavaEntityType.Method -> classHeader.write("    const smjni::java_method<")
-                    JavaEntityType.StaticMethod -> classHeader.write("    const smjni::java_static_method<")
-                    JavaEntityType.Field -> classHeader.write("    const smjni::java_field<")
-                    JavaEntityType.StaticField -> classHeader.write("    const smjni::java_static_field<")
-                    JavaEntityType.Constructor -> classHeader.write("    const smjni::java_constructor<")
+                    JavaEntityType.Method -> classHeader.write("    const smjni::${prefix}method<")
+                    JavaEntityType.StaticMethod -> classHeader.write("    const smjni::${prefix}static_method<")
+                    JavaEntityType.Field -> classHeader.write("    const smjni::${prefix}field<")
+                    JavaEntityType.StaticField -> classHeader.write("    const smjni::${prefix}static_field<")
+                    JavaEntityType.Constructor -> classHeader.write("    const smjni::${prefix}constructor<")
+                    JavaEntityType.NativePeer -> classHeader.write("    const smjni::native_peer<")
                 }
                 classHeader.write(javaEntity.templateArguments.joinToString(separator = ", "))
                 val memberName = "m_${javaEntity.name}"
@@ -240,6 +378,125 @@ internal class Generator {
         }
     }
 
+    private fun snapshotFieldNames(snapshot: Snapshot): List<UniqueName> {
+
+        val names = NameTable()
+        return snapshot.fields.map { names.allocateName(it.name) }
+    }
+
+    private fun generateSnapshotAccessors(snapshot: Snapshot?, classHeader: FileWriter) {
+
+        if (snapshot == null)
+            return
+
+        val fieldNames = snapshotFieldNames(snapshot)
+        classHeader.write("\n    struct ${snapshot.name}\n    {\n")
+        for (i in 0 until snapshot.fields.size)
+            classHeader.write("        ${snapshot.fields[i].nativeType} ${fieldNames[i]};\n")
+        classHeader.write("    };\n\n")
+        classHeader.write("    typedef smjni::java_snapshot_buffer<${snapshot.fields.size}> ${snapshot.bufferName};\n\n")
+
+        //all the fields are transferred in one call into Java through the reused buffer
+        classHeader.write("    ${snapshot.name} get_${snapshot.name}(JNIEnv * env, ${snapshot.selfType} self, ${snapshot.bufferName} & buffer) const;\n")
+        if (snapshot.fields.any { !it.isFinal })
+            classHeader.write("    void set_${snapshot.name}(JNIEnv * env, ${snapshot.selfType} self, ${snapshot.bufferName} & buffer, const ${snapshot.name} & value) const;\n")
+        classHeader.write("\n")
+    }
+
+    private fun generateSnapshotField(content: ClassContent, classHeader: FileWriter) {
+
+        val snapshot = content.snapshot ?: return
+
+        classHeader.write("    const smjni::java_field_snapshot<${content.cppName}, ${snapshot.cppHelperType}, ${snapshot.fields.size}> m_${snapshot.name};\n\n")
+    }
+
+    private fun generateSnapshotImplementation(content: ClassContent, classHeader: FileWriter) {
+
+        val snapshot = content.snapshot ?: return
+
+        val fieldNames = snapshotFieldNames(snapshot)
+        val memberName = "m_${snapshot.name}"
+        val structName = "${content.cppClassName}::${snapshot.name}"
+        val bufferName = "${content.cppClassName}::${snapshot.bufferName}"
+
+        classHeader.write("inline $structName ${content.cppClassName}::get_${snapshot.name}(JNIEnv * env, ${snapshot.selfType} self, $bufferName & buffer) const\n")
+        classHeader.write("{\n")
+        classHeader.write("    jlong values[${snapshot.fields.size}];\n")
+        classHeader.write("    $memberName.read(env, self, buffer, values);\n")
+        classHeader.write("    return {\n")
+        for (i in 0 until snapshot.fields.size)
+            classHeader.write("        smjni::internal::from_snapshot_slot<${snapshot.fields[i].nativeType}>(values[$i]),\n")
+        classHeader.write("    };\n")
+        classHeader.write("}\n\n")
+
+        if (snapshot.fields.any { !it.isFinal }) {
+            classHeader.write("inline void ${content.cppClassName}::set_${snapshot.name}(JNIEnv * env, ${snapshot.selfType} self, $bufferName & buffer, const $structName & value) const\n")
+            classHeader.write("{\n")
+            classHeader.write("    const jlong values[] = {\n")
+            for (name in fieldNames)
+                classHeader.write("        smjni::internal::to_snapshot_slot(value.$name),\n")
+            classHeader.write("    };\n")
+            classHeader.write("    $memberName.write(env, self, buffer, values);\n")
+            classHeader.write("}\n\n")
+        }
+    }
+
+    private fun generateSnapshotHelper(content: ClassContent, context: Context) {
+
+        val snapshot = content.snapshot ?: return
+
+        val packageEnd = snapshot.javaHelperName.lastIndexOf('.')
+        val simpleName = snapshot.javaHelperName.substring(packageEnd + 1)
+        val targetName = content.classElement.qualifiedName.toString()
+
+        println("JNIGen: Generating ${snapshot.javaHelperName}")
+
+        context.filer.createSourceFile(snapshot.javaHelperName, content.classElement).openWriter().use { helper ->
+
+            helper.write("//THIS FILE IS AUTO-GENERATED. DO NOT EDIT\n\n")
+            if (packageEnd >= 0)
+                helper.write("package ${snapshot.javaHelperName.substring(0, packageEnd)};\n\n")
+
+            helper.write("final class $simpleName {\n\n")
+            helper.write("    private $simpleName() {}\n\n")
+
+            //slots are native order longs in a direct buffer owned by the caller, see java_snapshot_buffer
+            helper.write("    static void read($targetName obj, java.nio.ByteBuffer slots) {\n")
+            helper.write("        slots.order(java.nio.ByteOrder.nativeOrder());\n")
+            for (i in 0 until snapshot.fields.size) {
+                val field = snapshot.fields[i]
+                val value = "obj.${field.name}"
+                val slot = when (field.kind) {
+                    TypeKind.BOOLEAN -> "$value ? 1 : 0"
+                    TypeKind.FLOAT -> "Float.floatToRawIntBits($value)"
+                    TypeKind.DOUBLE -> "Double.doubleToRawLongBits($value)"
+                    else -> value
+                }
+                helper.write("        slots.putLong(${i * 8}, $slot);\n")
+            }
+            helper.write("    }\n\n")
+
+            helper.write("    static void write($targetName obj, java.nio.ByteBuffer slots) {\n")
+            helper.write("        slots.order(java.nio.ByteOrder.nativeOrder());\n")
+            for (i in 0 until snapshot.fields.size) {
+                val field = snapshot.fields[i]
+                if (field.isFinal)
+                    continue
+                val slot = "slots.getLong(${i * 8})"
+                val value = when (field.kind) {
+                    TypeKind.BOOLEAN -> "$slot != 0"
+                    TypeKind.FLOAT -> "Float.intBitsToFloat((int)$slot)"
+                    TypeKind.DOUBLE -> "Double.longBitsToDouble($slot)"
+                    TypeKind.LONG -> slot
+                    else -> "(${field.kind.name.toLowerCase()})$slot"
+                }
+                helper.write("        obj.${field.name} = $value;\n")
+            }
+            helper.write("    }\n")
+            helper.write("}\n")
+        }
+    }
+
     private fun generateNativeMethodDeclarations(nativeMethods: List<NativeMethod>, classHeader: FileWriter) {
 
         if (nativeMethods.isNotEmpty()) {
@@ -266,9 +523,7 @@ internal class Generator {
 
         if (content.nativeMethods.isNotEmpty()) {
 
-            classHeader.write("inline void ${content.cppClassName}::register_methods(JNIEnv * env) const\n")
-            classHeader.write("{\n")
-            classHeader.write("    register_natives(env, {\n")
+            classHeader.write("inline const JNINativeMethod ${content.cppClassName}::native_methods[] = {\n")
             for(nativeMethod in content.nativeMethods) {
 
                 val cppName = StringBuilder()
@@ -282,14 +537,21 @@ internal class Generator {
                 }
                 cppName.append(nativeMethod.name)
 
-                if (nativeMethod.isStatic) {
-                    classHeader.write("        bind_native(\"${nativeMethod.name}\", $cppName),\n")
+                if (nativeMethod.isCritical) {
+                    classHeader.write("    bind_native<$cppName>(\"${nativeMethod.name}\"),\n")
+                }
+                else if (nativeMethod.isStatic) {
+                    classHeader.write("    bind_native(\"${nativeMethod.name}\", $cppName),\n")
                 }
                 else {
-                    classHeader.write("        bind_native(\"${nativeMethod.name}\", $cppName),\n")
+                    classHeader.write("    bind_native(\"${nativeMethod.name}\", $cppName),\n")
                 }
             }
-            classHeader.write("    });\n")
+            classHeader.write("};\n\n")
+
+            classHeader.write("inline void ${content.cppClassName}::register_methods(JNIEnv * env) const\n")
+            classHeader.write("{\n")
+            classHeader.write("    register_natives(env, native_methods);\n")
             classHeader.write("}\n\n")
         }
     }
@@ -302,6 +564,9 @@ internal class Generator {
         for (javaEntity in content.javaEntities) {
             val memberName = "m_${javaEntity.name}"
 
+            if (content.inlineAccessors && javaEntity.type != JavaEntityType.NativePeer)
+                continue
+
             when (javaEntity.type) {
                 JavaEntityType.Constructor ->
                     classHeader.write(",\n    $memberName(env, *this)")
@@ -309,7 +574,37 @@ internal class Generator {
                     classHeader.write(",\n    $memberName(env, *this, \"${javaEntity.name}\")")
             }
         }
-        classHeader.write("\n{}\n\n")
+        val snapshot = content.snapshot
+        if (snapshot != null)
+            classHeader.write(",\n    m_${snapshot.name}(env)")
+
+        if (!content.inlineAccessors) {
+            classHeader.write("\n{}\n\n")
+            return
+        }
+
+        classHeader.write("\n{\n")
+        for (javaEntity in content.javaEntities) {
+            val slot = "${inlineNamespaceOf(content)}::${content.idsName}::${javaEntity.name}"
+            val signatureArgs = javaEntity.templateArguments.filterIndexed { i, _ -> i != 1 }.joinToString(separator = ", ")
+
+            when (javaEntity.type) {
+                JavaEntityType.Method ->
+                    classHeader.write("    $slot.set(smjni::java_method_id<smjni::instance_method, $signatureArgs>(env, *this, \"${javaEntity.name}\").get());\n")
+                JavaEntityType.StaticMethod ->
+                    classHeader.write("    $slot.set(smjni::java_method_id<smjni::static_method, $signatureArgs>(env, *this, \"${javaEntity.name}\").get());\n")
+                JavaEntityType.Constructor -> {
+                    val ctorArgs = (listOf("void") + javaEntity.templateArguments.drop(1)).joinToString(separator = ", ")
+                    classHeader.write("    $slot.set(smjni::java_method_id<smjni::constructor, $ctorArgs>(env, *this).get());\n")
+                }
+                JavaEntityType.Field ->
+                    classHeader.write("    $slot.set(smjni::java_field_id<smjni::instance_field, ${javaEntity.templateArguments[0]}>(env, *this, \"${javaEntity.name}\").get());\n")
+                JavaEntityType.StaticField ->
+                    classHeader.write("    $slot.set(smjni::java_field_id<smjni::static_field, ${javaEntity.templateArguments[0]}>(env, *this, \"${javaEntity.name}\").get());\n")
+                JavaEntityType.NativePeer -> {}
+            }
+        }
+        classHeader.write("}\n\n")
     }
 
     private fun generateAllClassesHeader(headers: List<String>, typeMap: TypeMap, context: Context) {
@@ -330,6 +625,12 @@ internal class Generator {
 
             allHeader.write(headers.joinToString(separator = ", \\\n    ") { header -> typeMap.classesInHeader(header).filter {it.hasCppClass }.map { it.cppClassName }.joinToString(separator = ", \\\n    ")})
 
+            //classes for smjni::register_all_natives
+            allHeader.write("\n\n#define JNIGEN_ALL_NATIVE_CLASSES \\\n    ")
+
+            allHeader.write(headers.flatMap { header -> typeMap.classesInHeader(header).filter { it.hasCppClass && it.nativeMethods.isNotEmpty() } }
+                                   .joinToString(separator = ", \\\n    ") { it.cppClassName })
+
             allHeader.write("\n\n#endif\n")
         }
 
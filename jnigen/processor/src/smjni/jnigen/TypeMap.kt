@@ -32,7 +32,8 @@ internal class TypeMap(ctxt: Context, env: RoundEnvironment) {
 
     private val EXPOSED_TO_NATIVE = ctxt.exposedAnnotation
 
-    private class ExposedData(val cppName: String, val cppClassName: String, val header: String)
+    private class ExposedData(val cppName: String, val cppClassName: String, val header: String, val lazy: Boolean,
+                              val snapshot: Boolean, val inlineAccessors: Boolean)
 
     init {
 
@@ -104,7 +105,8 @@ internal class TypeMap(ctxt: Context, env: RoundEnvironment) {
             val convertsTo = HashSet<String>()
             collectConvertsTo(classElement, knownClasses, convertsTo)
             val binaryName = ctxt.elementUtils.getBinaryName(classElement).toString()
-            val content = ClassContent(classElement, binaryName, exposedData.cppClassName, convertsTo, this, ctxt)
+            val content = ClassContent(classElement, binaryName, exposedData.cppClassName, exposedData.lazy, exposedData.snapshot,
+                                       exposedData.inlineAccessors, convertsTo, this, ctxt)
             m_exposedClasses[classElement] = content
         }
     }
@@ -182,7 +184,7 @@ internal class TypeMap(ctxt: Context, env: RoundEnvironment) {
                 if (isArgument)
                     "const smjni::auto_java_ref<$rawType> &"
                 else
-                    "smjni::local_java_ref<$rawType>"
+                    "smjni::unique_local_ref<$rawType>"
             }
         }
     }
@@ -315,6 +317,9 @@ internal class TypeMap(ctxt: Context, env: RoundEnvironment) {
         var cppName: String? = null
         var cppClassName: String? = null
         var header: String? = null
+        var lazy = false
+        var snapshot = false
+        var inlineAccessors = false
         for((name, value) in elements.getElementValuesWithDefaults(annotation)) {
 
             when {
@@ -322,19 +327,25 @@ internal class TypeMap(ctxt: Context, env: RoundEnvironment) {
                 name.simpleName.contentEquals("typeName") -> cppName = value.value.toString()
                 name.simpleName.contentEquals("className") -> cppClassName = value.value.toString()
                 name.simpleName.contentEquals("header") -> header = value.value.toString()
+                name.simpleName.contentEquals("lazy") -> lazy = value.value as Boolean
+                name.simpleName.contentEquals("snapshot") -> snapshot = value.value as Boolean
+                name.simpleName.contentEquals("inlineAccessors") -> inlineAccessors = value.value as Boolean
             }
         }
         if (stem == null)
             return null
 
-        return makeExposedData(classElement, stem, cppName, cppClassName, header)
+        return makeExposedData(classElement, stem, cppName, cppClassName, header, lazy, snapshot, inlineAccessors)
 
     }
 
     private fun makeExposedData(classElement: TypeElement, stem: String,
                                 cppName: String? = null,
                                 cppClassName: String? = null,
-                                header: String? = null): ExposedData
+                                header: String? = null,
+                                lazy: Boolean = false,
+                                snapshot: Boolean = false,
+                                inlineAccessors: Boolean = false): ExposedData
     {
 
         val derivedStem = if (stem.isNotEmpty())
@@ -357,7 +368,10 @@ internal class TypeMap(ctxt: Context, env: RoundEnvironment) {
         else
             header
 
-        return ExposedData(derivedCppName, derivedCppClassName, derivedHeader)
+        if (lazy && inlineAccessors)
+            throw ProcessingException("lazy and inlineAccessors cannot be combined", classElement)
+
+        return ExposedData(derivedCppName, derivedCppClassName, derivedHeader, lazy, snapshot, inlineAccessors)
     }
 
     private fun getStemName(classElement: TypeElement) : String {
@@ -0,0 +1,33 @@
+/*
+ Copyright 2019 SmJNI Contributors
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include "stdpch.h"
+
+#include <smjni/global_ref_pool.h>
+
+using namespace smjni;
+
+std::atomic<size_t> global_ref_pool::s_created{0};
+std::atomic<size_t> global_ref_pool::s_deleted{0};
+
+global_ref_pool::statistics global_ref_pool::get_statistics() noexcept
+{
+    statistics ret;
+    ret.created = s_created.load(std::memory_order_relaxed);
+    ret.deleted = s_deleted.load(std::memory_order_relaxed);
+    ret.live = ret.created >= ret.deleted ? ret.created - ret.deleted : 0;
+    return ret;
+}
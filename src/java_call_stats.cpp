@@ -0,0 +1,217 @@
+/*
+ Copyright 2019 SmJNI Contributors
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include "stdpch.h"
+
+#include <smjni/java_call_stats.h>
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <thread>
+
+using namespace smjni;
+using namespace smjni::internal;
+
+std::atomic<bool> java_call_stats::s_enabled{false};
+
+namespace
+{
+    class call_site_registry
+    {
+    public:
+        java_call_site * get(const char * kind, const char * class_name, const char * name, const char * signature)
+        {
+            std::string key = kind;
+            key += ' ';
+            key += class_name;
+            key += '.';
+            key += name;
+            key += signature;
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_index.find(key);
+            if (it != m_index.end())
+                return it->second;
+            java_call_site & ret = m_sites.emplace_back(kind, class_name, name, signature);
+            m_index.emplace(std::move(key), &ret);
+            return &ret;
+        }
+
+        template<typename Func>
+        void for_each(Func func)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (auto & site: m_sites)
+                func(site);
+        }
+    private:
+        std::mutex m_mutex;
+        //deque never moves existing elements
+        std::deque<java_call_site> m_sites;
+        std::map<std::string, java_call_site *> m_index;
+    };
+
+    call_site_registry & registry()
+    {
+        //leaked so that sites remain valid during static destruction
+        static call_site_registry * instance = new call_site_registry;
+        return *instance;
+    }
+
+    double measure_ns_per_tick()
+    {
+        using namespace std::chrono;
+
+        auto start_time = steady_clock::now();
+        uint64_t start_ticks = call_clock_ticks();
+        std::this_thread::sleep_for(milliseconds(10));
+        uint64_t end_ticks = call_clock_ticks();
+        auto end_time = steady_clock::now();
+
+        if (end_ticks <= start_ticks)
+            return 1;
+        return double(duration_cast<nanoseconds>(end_time - start_time).count()) / double(end_ticks - start_ticks);
+    }
+
+    double ns_per_tick()
+    {
+        static const double value = measure_ns_per_tick();
+        return value;
+    }
+
+    void append_json_string(std::string & dest, const char * str)
+    {
+        dest += '"';
+        for ( ; *str; ++str)
+        {
+            char c = *str;
+            if (c == '"' || c == '\\')
+            {
+                dest += '\\';
+                dest += c;
+            }
+            else if ((unsigned char)c < 0x20)
+            {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\u%04x", unsigned(c));
+                dest += buf;
+            }
+            else
+            {
+                dest += c;
+            }
+        }
+        dest += '"';
+    }
+
+    void append_json_number(std::string & dest, const char * name, uint64_t value)
+    {
+        char buf[64];
+        snprintf(buf, sizeof(buf), ",\"%s\":%" PRIu64, name, value);
+        dest += buf;
+    }
+
+    void append_site(std::string & dest, const java_call_site & site, double scale)
+    {
+        uint64_t counts[java_call_site::bucket_count];
+        uint64_t total_count = 0;
+        for (unsigned i = 0; i < java_call_site::bucket_count; ++i)
+            total_count += (counts[i] = site.count(i));
+        if (total_count == 0)
+            return;
+
+        auto to_ns = [scale] (uint64_t ticks) {
+            return uint64_t(double(ticks) * scale + 0.5);
+        };
+        auto percentile = [&] (uint64_t per_mille) {
+            uint64_t threshold = (total_count * per_mille + 999) / 1000;
+            uint64_t seen = 0;
+            for (unsigned i = 0; i < java_call_site::bucket_count; ++i)
+            {
+                seen += counts[i];
+                if (seen >= threshold)
+                    return to_ns(java_call_site::bucket_low(i));
+            }
+            return to_ns(site.max());
+        };
+
+        if (dest.back() != '[')
+            dest += ',';
+        dest += "{\"kind\":";
+        append_json_string(dest, site.kind());
+        dest += ",\"class\":";
+        append_json_string(dest, site.class_name());
+        dest += ",\"name\":";
+        append_json_string(dest, site.name().c_str());
+        dest += ",\"signature\":";
+        append_json_string(dest, site.signature());
+        append_json_number(dest, "count", total_count);
+        append_json_number(dest, "total_ns", to_ns(site.total()));
+        append_json_number(dest, "mean_ns", to_ns(site.total() / total_count));
+        append_json_number(dest, "p50_ns", percentile(500));
+        append_json_number(dest, "p90_ns", percentile(900));
+        append_json_number(dest, "p99_ns", percentile(990));
+        append_json_number(dest, "p999_ns", percentile(999));
+        append_json_number(dest, "max_ns", to_ns(site.max()));
+        dest += ",\"histogram\":[";
+        bool first = true;
+        for (unsigned i = 0; i < java_call_site::bucket_count; ++i)
+        {
+            if (!counts[i])
+                continue;
+            char buf[64];
+            snprintf(buf, sizeof(buf), "%s[%" PRIu64 ",%" PRIu64 "]", first ? "" : ",",
+                     to_ns(java_call_site::bucket_low(i)), counts[i]);
+            dest += buf;
+            first = false;
+        }
+        dest += "]}";
+    }
+}
+
+void java_call_site::reset() noexcept
+{
+    for (auto & bucket: m_buckets)
+        bucket.store(0, std::memory_order_relaxed);
+    m_total.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+java_call_site * internal::register_call_site(const char * kind, const char * class_name, const char * name, const char * signature)
+{
+    return registry().get(kind, class_name, name, signature);
+}
+
+std::string java_call_stats::snapshot_json()
+{
+    double scale = ns_per_tick();
+    std::string ret = "{\"methods\":[";
+    registry().for_each([&] (const java_call_site & site) {
+        append_site(ret, site, scale);
+    });
+    ret += "]}";
+    return ret;
+}
+
+void java_call_stats::reset()
+{
+    registry().for_each([] (java_call_site & site) {
+        site.reset();
+    });
+}
@@ -0,0 +1,174 @@
+/*
+ Copyright 2019 SmJNI Contributors
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include "stdpch.h"
+
+#include <cstring>
+#include <limits>
+
+#include <smjni/java_event_batcher.h>
+#include <smjni/java_frame.h>
+#include <smjni/java_exception.h>
+
+using namespace smjni;
+using namespace smjni::internal;
+
+event_batch_queue::event_batch_queue(size_t record_size, const java_event_batcher_policy & policy,
+                                     deliver_func deliver, void * context, const char * thread_name):
+    m_record_size(record_size),
+    m_policy(policy),
+    m_deliver(deliver),
+    m_context(context)
+{
+    if (m_record_size == 0 || m_policy.batch_size == 0 || m_policy.batch_count == 0)
+        THROW_JAVA_PROBLEM("event batcher sizes must be positive");
+    if (m_policy.batch_size > size_t(std::numeric_limits<jint>::max()) / m_record_size)
+        THROW_JAVA_PROBLEM("event batch of %zu records is too large", m_policy.batch_size);
+
+    m_batches.resize(m_policy.batch_count);
+    for (auto & batch: m_batches)
+        batch.data.reset(new unsigned char[m_policy.batch_size * m_record_size]);
+
+    std::promise<void> started;
+    m_thread = std::thread(&event_batch_queue::run, this, std::string(thread_name), std::ref(started));
+    try
+    {
+        started.get_future().get();
+    }
+    catch(...)
+    {
+        m_thread.join();
+        throw;
+    }
+}
+
+event_batch_queue::~event_batch_queue() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_work.notify_one();
+    m_thread.join();
+}
+
+void event_batch_queue::push(const void * record)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_progress.wait(lock, [this] () {
+        return m_sealed < m_batches.size();
+    });
+
+    batch & current = m_batches[(m_next_delivery + m_sealed) % m_batches.size()];
+    memcpy(current.data.get() + current.count * m_record_size, record, m_record_size);
+    ++m_pushed;
+    //only wake the delivery thread when there is something new for it to do
+    if (++current.count == m_policy.batch_size)
+        ++m_sealed;
+    else if (current.count == 1)
+        m_deadline = std::chrono::steady_clock::now() + m_policy.max_delay;
+    else
+        return;
+    lock.unlock();
+    m_work.notify_one();
+}
+
+void event_batch_queue::flush()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    unsigned long long target = m_pushed;
+    if (m_delivered >= target)
+        return;
+    if (m_flush_target < target)
+        m_flush_target = target;
+    m_work.notify_one();
+    m_progress.wait(lock, [this, target] () {
+        return m_delivered >= target;
+    });
+}
+
+void event_batch_queue::run(std::string name, std::promise<void> & started) noexcept
+{
+    JNIEnv * env;
+    try
+    {
+        env = jni_provider::attach_current_thread(name.c_str());
+        java_frame frame(env, 1);
+        for (auto & batch: m_batches)
+        {
+            java_direct_buffer<unsigned char> data(batch.data.get(), jlong(m_policy.batch_size * m_record_size));
+            batch.buffer = data.to_java(env);
+        }
+        started.set_value();
+    }
+    catch(...)
+    {
+        started.set_exception(std::current_exception());
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for ( ; ; )
+    {
+        if (m_sealed == 0)
+        {
+            batch & filling = m_batches[m_next_delivery];
+            if (filling.count == 0)
+            {
+                if (m_stopping)
+                    break;
+                m_work.wait(lock);
+                continue;
+            }
+            if (!m_stopping && m_flush_target <= m_delivered && std::chrono::steady_clock::now() < m_deadline)
+            {
+                m_work.wait_until(lock, m_deadline);
+                continue;
+            }
+            ++m_sealed;
+        }
+        deliver_next(env, lock);
+    }
+    lock.unlock();
+
+    for (auto & batch: m_batches)
+        global_java_ref<jByteBuffer>().swap(batch.buffer);
+}
+
+void event_batch_queue::deliver_next(JNIEnv * env, std::unique_lock<std::mutex> & lock) noexcept
+{
+    //sealed batches are never touched by producers so the lock is not needed while Java reads it
+    batch & current = m_batches[m_next_delivery];
+    size_t count = current.count;
+    lock.unlock();
+    try
+    {
+        java_frame frame(env, 16);
+        m_deliver(m_context, env, current.buffer, jint(count));
+        java_exception::check(env);
+    }
+    catch(std::exception & ex)
+    {
+        internal::do_log_error(ex, "batch of %zu events was not delivered", count);
+    }
+    lock.lock();
+
+    current.count = 0;
+    m_next_delivery = (m_next_delivery + 1) % m_batches.size();
+    --m_sealed;
+    m_delivered += count;
+    m_progress.notify_all();
+}
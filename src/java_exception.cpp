@@ -17,22 +17,34 @@
 
 #include "stdpch.h"
 
-#include <vector>
-#include <iterator>
+#if !defined(_WIN32)
+    #include <dlfcn.h>
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 
 #include <smjni/java_string.h>
 #include <smjni/java_exception.h>
+#include <smjni/java_exception_dispatcher.h>
+#include <smjni/java_exception_translator.h>
 #include <smjni/java_runtime.h>
+#include <smjni/java_frame.h>
 
 using namespace smjni;
 
+static const char g_what_prefix[] = "smjni::java_exception";
+
 const char * java_exception::what() const noexcept
 { 
-    if (m_what.empty())
+    if (!m_what[0])
     {
+        static_assert(sizeof(g_what_prefix) <= s_what_capacity);
+        memcpy(m_what, g_what_prefix, sizeof(g_what_prefix));
         try
         {
-            m_what = do_what(); 
+            do_what(); 
         }
         catch(std::exception & ex)
         {
@@ -40,31 +52,144 @@ const char * java_exception::what() const noexcept
             //ignore
         }
     }
-    return m_what.c_str();
+    return m_what;
 }
 
-std::string java_exception::do_what() const
+void java_exception::do_what() const
 {
-    std::string ret = "smjni::java_exception";
+    constexpr size_t prefix_len = sizeof(g_what_prefix) - 1;
+    constexpr size_t available = s_what_capacity - prefix_len - 3; //": " and terminating 0
     
     JNIEnv * jenv = jni_provider::get_jni();
     auto message = java_runtime::object().toString(jenv, m_throwable.c_ptr());
     if (!message)
-        return ret;
+        return;
     jsize len = java_string_get_length(jenv, message);
     if (!len)
-        return ret;
-    std::vector<jchar> buf(len);
-    java_string_get_region(jenv, message, 0, len, &buf[0]);
-    ret += ": ";
-    utf16_to_utf8(buf.begin(), buf.end(), std::back_inserter(ret));
-    return ret;
+        return;
+    
+    //every UTF-16 unit produces at least one byte so no more than available of them are needed
+    jchar utf16[available];
+    len = std::min(len, jsize(available));
+    java_string_get_region(jenv, message, 0, len, utf16);
+    
+    char utf8[available * 3];
+    size_t utf8_len = size_t(utf16_to_utf8(utf16, utf16 + len, utf8) - utf8);
+    if (utf8_len > available)
+    {
+        //do not cut a multi-byte sequence
+        utf8_len = available;
+        while (utf8_len && (uint8_t(utf8[utf8_len]) & 0xC0) == 0x80)
+            --utf8_len;
+    }
+    
+    char * dest = m_what + prefix_len;
+    *dest++ = ':';
+    *dest++ = ' ';
+    memcpy(dest, utf8, utf8_len);
+    dest[utf8_len] = 0;
+}
+
+void java_exception::throw_pending(JNIEnv * jenv, jthrowable ex)
+{
+    if (auto dispatcher = s_dispatcher.load(std::memory_order_acquire))
+        dispatcher->raise(jenv, ex);
+    throw java_exception(ex);
 }
 
 void java_exception::translate(JNIEnv * env, const std::exception & ex)
 {
-    const char * message = ex.what();
-    auto java_message = java_string_create(env, message);
-    auto exception = java_runtime::throwable().ctor(env, java_message);
-    java_exception::raise(env, exception);
+    if (dynamic_cast<const std::bad_alloc *>(&ex))
+    {
+        java_exception::raise(env, java_runtime::out_of_memory_error());
+        return;
+    }
+    if (dynamic_cast<const native_stack_overflow *>(&ex))
+    {
+        java_exception::raise(env, java_runtime::stack_overflow_error());
+        return;
+    }
+    if (!java_exception_translator::raise(env, ex))
+        java_exception_translator::throw_new(env, java_runtime::throwable().c_ptr(), ex.what());
+    
+    auto backtrace = native_backtrace::of(ex);
+    if (backtrace && *backtrace)
+        attach_backtrace(env, *backtrace);
+}
+
+//Prepends the native frames to the stack trace of the pending Java exception.
+//Frames are described by module and offset only, symbolization is too slow for this path.
+//The preallocated OutOfMemoryError is shared by all threads and is left untouched.
+void java_exception::attach_backtrace(JNIEnv * env, const native_backtrace & backtrace) noexcept
+{
+    auto pending = jattach(env, env->ExceptionOccurred());
+    if (!pending)
+        return;
+    env->ExceptionClear();
+    if (env->IsSameObject(pending.c_ptr(), java_runtime::out_of_memory_error().c_ptr()))
+    {
+        env->Throw(pending.c_ptr());
+        return;
+    }
+    try
+    {
+        java_frame frame(env, 8);
+        
+        auto element_class = jattach(env, env->FindClass("java/lang/StackTraceElement"));
+        java_exception::check(env);
+        jmethodID element_ctor = env->GetMethodID(element_class.c_ptr(), "<init>", 
+                                                  "(Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;I)V");
+        java_exception::check(env);
+        jclass throwable_class = java_runtime::throwable().c_ptr();
+        jmethodID get_trace = env->GetMethodID(throwable_class, "getStackTrace", "()[Ljava/lang/StackTraceElement;");
+        java_exception::check(env);
+        jmethodID set_trace = env->GetMethodID(throwable_class, "setStackTrace", "([Ljava/lang/StackTraceElement;)V");
+        java_exception::check(env);
+        
+        auto java_trace = jattach(env, static_cast<jobjectArray>(env->CallObjectMethod(pending.c_ptr(), get_trace)));
+        java_exception::check(env);
+        jsize java_size = java_trace ? env->GetArrayLength(java_trace.c_ptr()) : 0;
+        jsize native_size = jsize(backtrace.size());
+        
+        auto trace = jattach(env, env->NewObjectArray(native_size + java_size, element_class.c_ptr(), nullptr));
+        java_exception::check(env);
+        for (jsize i = 0; i < native_size; ++i)
+        {
+            const void * address = backtrace.addresses()[i];
+            const char * module = "<native>";
+            uintptr_t offset = reinterpret_cast<uintptr_t>(address);
+#if !defined(_WIN32)
+            Dl_info info;
+            if (dladdr(address, &info) && info.dli_fname)
+            {
+                module = info.dli_fname;
+                if (const char * slash = strrchr(module, '/'))
+                    module = slash + 1;
+                offset -= reinterpret_cast<uintptr_t>(info.dli_fbase);
+            }
+#endif
+            char method[2 + 2 * sizeof(uintptr_t) + 1];
+            snprintf(method, sizeof(method), "0x%llx", (unsigned long long)offset);
+            
+            auto class_name = java_string_create(env, module);
+            auto method_name = java_string_create(env, method);
+            //-2 marks a native method
+            auto element = jattach(env, env->NewObject(element_class.c_ptr(), element_ctor, 
+                                                       class_name.c_ptr(), method_name.c_ptr(), nullptr, jint(-2)));
+            java_exception::check(env);
+            env->SetObjectArrayElement(trace.c_ptr(), i, element.c_ptr());
+        }
+        for (jsize i = 0; i < java_size; ++i)
+        {
+            auto element = jattach(env, env->GetObjectArrayElement(java_trace.c_ptr(), i));
+            env->SetObjectArrayElement(trace.c_ptr(), native_size + i, element.c_ptr());
+        }
+        env->CallVoidMethod(pending.c_ptr(), set_trace, trace.c_ptr());
+        java_exception::check(env);
+    }
+    catch(std::exception & ex)
+    {
+        internal::do_log_error(ex, "unable to attach native backtrace");
+    }
+    env->Throw(pending.c_ptr());
 }
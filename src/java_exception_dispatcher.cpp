@@ -0,0 +1,49 @@
+/*
+ Copyright 2019 SmJNI Contributors
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include "stdpch.h"
+
+#include <algorithm>
+
+#include <smjni/java_exception_dispatcher.h>
+
+using namespace smjni;
+
+const java_exception_dispatcher * java_exception_dispatcher::install(const java_exception_dispatcher * dispatcher) noexcept
+{
+    return java_exception::s_dispatcher.exchange(dispatcher, std::memory_order_acq_rel);
+}
+
+void java_exception_dispatcher::add(jclass clazz, thrower do_throw)
+{
+    //Insert before the first registered superclass. Anything derived from the new class is
+    //derived from that superclass too and so already comes before it
+    JNIEnv * jenv = jni_provider::get_jni();
+    auto it = std::find_if(m_handlers.begin(), m_handlers.end(), [jenv, clazz] (const handler & existing) {
+        return jenv->IsAssignableFrom(clazz, existing.clazz);
+    });
+    m_handlers.insert(it, {clazz, do_throw});
+}
+
+void java_exception_dispatcher::raise(JNIEnv * jenv, jthrowable ex) const
+{
+    for (auto & entry: m_handlers)
+    {
+        if (jenv->IsInstanceOf(ex, entry.clazz))
+            entry.do_throw(ex);
+    }
+    throw java_exception(ex);
+}
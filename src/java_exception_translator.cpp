@@ -0,0 +1,162 @@
+/*
+ Copyright 2019 SmJNI Contributors
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include "stdpch.h"
+
+#include <vector>
+#include <shared_mutex>
+
+#include <smjni/java_exception_translator.h>
+#include <smjni/java_string.h>
+#include <smjni/java_runtime.h>
+
+using namespace smjni;
+
+namespace
+{
+    struct translation
+    {
+        jclass clazz;
+        jmethodID ctor;
+        global_java_ref<jstring> message;
+        bool (*matches)(const std::exception &);
+    };
+
+    //Allocated on first use and only freed by clear() so that no global references
+    //are released by static destructors after the VM is gone
+    std::vector<translation> * g_translations = nullptr;
+    std::shared_mutex g_translations_mutex;
+
+    jmethodID get_message_ctor(JNIEnv * jenv, jclass clazz)
+    {
+        jmethodID ret = jenv->GetMethodID(clazz, "<init>", "(Ljava/lang/String;)V");
+        if (!ret)
+        {
+            java_exception::check(jenv);
+            THROW_JAVA_PROBLEM("exception class has no (String) constructor");
+        }
+        return ret;
+    }
+
+    //Whatever went wrong while creating the exception, an OutOfMemoryError is the most likely cause
+    void raise_out_of_memory(JNIEnv * jenv)
+    {
+        jenv->ExceptionClear();
+        java_exception::raise(jenv, java_runtime::out_of_memory_error());
+    }
+
+    void raise_new_object(JNIEnv * jenv, jclass clazz, jmethodID ctor, jstring message)
+    {
+        auto ex = jattach(jenv, static_cast<jthrowable>(jenv->NewObject(clazz, ctor, message)));
+        if (!ex)
+            raise_out_of_memory(jenv);
+        else
+            java_exception::raise(jenv, ex);
+    }
+
+    bool is_continuation(uint8_t byte) noexcept
+    {
+        return (byte & 0xC0) == 0x80;
+    }
+
+    //ThrowNew takes modified UTF-8 which only agrees with well-formed UTF-8 without supplementary
+    //characters (embedded 0 cannot occur in a C string). Anything else must go through java_string_create.
+    bool is_modified_utf8_compatible(const char * str) noexcept
+    {
+        auto p = reinterpret_cast<const uint8_t *>(str);
+        while (*p)
+        {
+            uint8_t lead = *p++;
+            if (lead < 0x80)
+                continue;
+            if (lead >= 0xC2 && lead <= 0xDF)
+            {
+                if (!is_continuation(*p++))
+                    return false;
+                continue;
+            }
+            if (lead < 0xE0 || lead > 0xEF)
+                return false;
+            //Reject overlong forms (E0 80..9F) and surrogates (ED A0..BF)
+            uint8_t min = lead == 0xE0 ? 0xA0 : 0x80;
+            uint8_t max = lead == 0xED ? 0x9F : 0xBF;
+            if (*p < min || *p > max)
+                return false;
+            ++p;
+            if (!is_continuation(*p++))
+                return false;
+        }
+        return true;
+    }
+}
+
+void java_exception_translator::add(JNIEnv * jenv, jclass clazz, const char * message, matcher matches)
+{
+    translation entry{clazz, get_message_ctor(jenv, clazz), nullptr, matches};
+    if (message)
+        entry.message = java_string_create(jenv, message);
+
+    std::unique_lock lock(g_translations_mutex);
+    if (!g_translations)
+        g_translations = new std::vector<translation>();
+    g_translations->push_back(std::move(entry));
+}
+
+void java_exception_translator::clear() noexcept
+{
+    std::unique_lock lock(g_translations_mutex);
+    delete g_translations;
+    g_translations = nullptr;
+}
+
+bool java_exception_translator::raise(JNIEnv * jenv, const std::exception & ex)
+{
+    std::shared_lock lock(g_translations_mutex);
+    if (!g_translations)
+        return false;
+    for (auto & entry: *g_translations)
+    {
+        if (!entry.matches(ex))
+            continue;
+        if (entry.message)
+            raise_new_object(jenv, entry.clazz, entry.ctor, entry.message.c_ptr());
+        else
+            throw_new(jenv, entry.clazz, ex.what());
+        return true;
+    }
+    return false;
+}
+
+void java_exception_translator::throw_new(JNIEnv * jenv, jclass clazz, const char * message)
+{
+    if (is_modified_utf8_compatible(message))
+    {
+        if (jenv->ThrowNew(clazz, message) != 0)
+            raise_out_of_memory(jenv);
+        return;
+    }
+
+    try
+    {
+        auto java_message = java_string_create(jenv, message);
+        raise_new_object(jenv, clazz, get_message_ctor(jenv, clazz), java_message.c_ptr());
+    }
+    catch(std::exception & ex)
+    {
+        internal::do_log_error(ex, "unable to create Java exception");
+        raise_out_of_memory(jenv);
+    }
+}
@@ -21,16 +21,256 @@
     #include <android/log.h>
 #endif
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <stdexcept>
+#include <thread>
+#include <stdio.h>
 #include <stdlib.h>
 
 #include <smjni/java_externals.h>
+#include <smjni/native_backtrace.h>
 
 using namespace smjni;
 
 static void (*g_throw_problem)(const char *, const char *, va_list) = nullptr;
 static void (*g_log_error)(const std::exception &, const char *, va_list) noexcept = nullptr;
 
+static void default_log_sink(const char * message) noexcept
+{
+#ifdef __ANDROID__
+    __android_log_write(ANDROID_LOG_ERROR, "smjni", message);
+#else
+    fputs(message, stderr);
+    fputc('\n', stderr);
+#endif
+}
+
+namespace
+{
+    //Writes fixed-size text records to the sink, either directly or through a bounded
+    //multi-producer single-consumer queue. Producers never block: when the queue is full
+    //the record is dropped and counted. Never destroyed, the thread is only stopped by shutdown().
+    class error_log
+    {
+    private:
+        static constexpr size_t s_capacity = 128;
+        static constexpr size_t s_record_size = 512;
+        static constexpr auto s_idle_wait = std::chrono::milliseconds(100);
+        
+        struct record
+        {
+            std::atomic<size_t> sequence;
+            char text[s_record_size];
+        };
+    public:
+        error_log() noexcept
+        {
+            for (size_t i = 0; i < s_capacity; ++i)
+                m_records[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        
+        void set_sink(void (*sink)(const char *) noexcept) noexcept
+            { m_sink.store(sink ? sink : default_log_sink, std::memory_order_release); }
+        
+        void set_rate_limit(unsigned per_second) noexcept
+            { m_rate_limit.store(per_second, std::memory_order_relaxed); }
+        
+        void set_async(bool enabled) noexcept
+        {
+            if (m_shut_down.load(std::memory_order_acquire))
+                return;
+            m_async.store(enabled, std::memory_order_relaxed);
+            if (!enabled)
+                flush();
+        }
+        
+        void log(const std::exception & ex, const char * format, va_list vl) noexcept
+        {
+            if (!admit())
+                return;
+            
+            if (!m_async.load(std::memory_order_relaxed))
+            {
+                auto sink = m_sink.load(std::memory_order_acquire);
+                report_dropped(sink);
+                char text[s_record_size];
+                format_record(text, ex, format, vl);
+                sink(text);
+                return;
+            }
+            
+            size_t pos = m_enqueue_pos.load(std::memory_order_relaxed);
+            record * rec;
+            for ( ; ; )
+            {
+                rec = &m_records[pos % s_capacity];
+                size_t sequence = rec->sequence.load(std::memory_order_acquire);
+                auto diff = intptr_t(sequence) - intptr_t(pos);
+                if (diff == 0)
+                {
+                    if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (diff < 0)
+                {
+                    m_dropped.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                else
+                {
+                    pos = m_enqueue_pos.load(std::memory_order_relaxed);
+                }
+            }
+            
+            format_record(rec->text, ex, format, vl);
+            rec->sequence.store(pos + 1, std::memory_order_release);
+            
+            start();
+            m_wakeup.notify_one();
+        }
+        
+        void flush() noexcept
+        {
+            size_t target = m_enqueue_pos.load(std::memory_order_acquire);
+            while (m_processed.load(std::memory_order_acquire) < target && m_thread_started.load(std::memory_order_acquire))
+            {
+                m_wakeup.notify_one();
+                std::this_thread::yield();
+            }
+        }
+        
+        void shutdown() noexcept
+        {
+            if (m_shut_down.exchange(true, std::memory_order_acq_rel))
+                return;
+            m_async.store(false, std::memory_order_relaxed);
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stopping = true;
+            }
+            m_wakeup.notify_one();
+            if (m_thread.joinable())
+                m_thread.join();
+            m_thread_started.store(false, std::memory_order_release);
+            //nothing else consumes now, pick up records that raced with the thread's last pass
+            drain();
+        }
+    private:
+        static void format_record(char (&text)[s_record_size], const std::exception & ex, const char * format, va_list vl) noexcept
+        {
+            int len = snprintf(text, s_record_size, "%s", ex.what());
+            if (format && len >= 0 && size_t(len) + 1 < s_record_size)
+            {
+                text[len] = '\n';
+                vsnprintf(text + len + 1, s_record_size - len - 1, format, vl);
+            }
+        }
+        
+        void report_dropped(void (*sink)(const char *) noexcept) noexcept
+        {
+            if (size_t dropped = m_dropped.exchange(0, std::memory_order_relaxed))
+            {
+                char message[64];
+                snprintf(message, sizeof(message), "smjni: %zu error messages dropped", dropped);
+                sink(message);
+            }
+        }
+        
+        //at most m_rate_limit records per one second window
+        bool admit() noexcept
+        {
+            unsigned limit = m_rate_limit.load(std::memory_order_relaxed);
+            if (!limit)
+                return true;
+            auto now = std::chrono::duration_cast<std::chrono::seconds>(
+                            std::chrono::steady_clock::now().time_since_epoch()).count();
+            auto window = m_window.load(std::memory_order_relaxed);
+            if (now != window && m_window.compare_exchange_strong(window, now, std::memory_order_relaxed))
+                m_window_count.store(0, std::memory_order_relaxed);
+            if (m_window_count.fetch_add(1, std::memory_order_relaxed) < limit)
+                return true;
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        
+        void start() noexcept
+        {
+            if (m_thread_started.load(std::memory_order_acquire))
+                return;
+            std::call_once(m_start_flag, [this] () {
+                try
+                {
+                    m_thread = std::thread(&error_log::run, this);
+                    m_thread_started.store(true, std::memory_order_release);
+                }
+                catch(std::exception &)
+                {
+                    //records stay queued and are lost
+                }
+            });
+        }
+        
+        void run() noexcept
+        {
+            for ( ; ; )
+            {
+                drain();
+                
+                std::unique_lock<std::mutex> lock(m_mutex);
+                if (m_stopping)
+                    break;
+                m_wakeup.wait_for(lock, s_idle_wait);
+            }
+            drain();
+        }
+        
+        void drain() noexcept
+        {
+            auto sink = m_sink.load(std::memory_order_acquire);
+            for ( ; ; )
+            {
+                record & rec = m_records[m_dequeue_pos % s_capacity];
+                if (rec.sequence.load(std::memory_order_acquire) != m_dequeue_pos + 1)
+                    break;
+                sink(rec.text);
+                rec.sequence.store(m_dequeue_pos + s_capacity, std::memory_order_release);
+                ++m_dequeue_pos;
+                m_processed.store(m_dequeue_pos, std::memory_order_release);
+            }
+            report_dropped(sink);
+        }
+    private:
+        record m_records[s_capacity];
+        std::atomic<size_t> m_enqueue_pos{0};
+        size_t m_dequeue_pos = 0;
+        std::atomic<size_t> m_processed{0};
+        std::atomic<size_t> m_dropped{0};
+        
+        std::atomic<void (*)(const char *) noexcept> m_sink{default_log_sink};
+        std::atomic<bool> m_async{true};
+        std::atomic<unsigned> m_rate_limit{0};
+        std::atomic<long long> m_window{0};
+        std::atomic<unsigned> m_window_count{0};
+        
+        std::once_flag m_start_flag;
+        std::atomic<bool> m_thread_started{false};
+        std::atomic<bool> m_shut_down{false};
+        std::thread m_thread;
+        std::mutex m_mutex;
+        std::condition_variable m_wakeup;
+        bool m_stopping = false;
+    };
+    
+    error_log & get_error_log()
+    {
+        //leaked so that static destruction never joins the thread
+        static error_log * instance = new error_log;
+        return *instance;
+    }
+}
+
 void smjni::set_externals(void (*thrower)(const char *, const char *, va_list), 
                           void (*logger)(const std::exception &, const char *, va_list) noexcept)
 {
@@ -38,13 +278,51 @@ void smjni::set_externals(void (*thrower)(const char *, const char *, va_list),
     g_log_error = logger;
 }
 
+void smjni::set_externals(void (*thrower)(const char *, const char *, va_list), 
+                          void (*logger)(const std::exception &, const char *, va_list) noexcept,
+                          void (*log_sink)(const char * message) noexcept)
+{
+    set_externals(thrower, logger);
+    get_error_log().set_sink(log_sink);
+}
+
+void smjni::set_log_async(bool enabled) noexcept
+{
+    get_error_log().set_async(enabled);
+}
+
+void smjni::set_log_rate_limit(unsigned per_second) noexcept
+{
+    get_error_log().set_rate_limit(per_second);
+}
+
+void smjni::flush_log() noexcept
+{
+    get_error_log().flush();
+}
+
+void smjni::shutdown_log() noexcept
+{
+    get_error_log().shutdown();
+}
+
+//Formats into a stack buffer first so that short messages need a single pass
 static std::string print_to_string(const char * format, va_list vl)
 {
     va_list vlOrig;
     va_copy(vlOrig, vl);
-    auto size = vsnprintf(nullptr, 0, format, vl);
+    char stack_buf[256];
+    auto size = vsnprintf(stack_buf, sizeof(stack_buf), format, vl);
     if (size <= 0)
+    {
+        va_end(vlOrig);
         return std::string();
+    }
+    if (size_t(size) < sizeof(stack_buf))
+    {
+        va_end(vlOrig);
+        return std::string(stack_buf, size);
+    }
     std::string buf(size + 1, '\0');
     size = vsnprintf(&buf[0], buf.size(), format, vlOrig);
     va_end(vlOrig);
@@ -65,7 +343,7 @@ static std::string print_to_string(const char * format, va_list vl)
     std::string message = print_to_string(format, vl);
     message += "at ";
     message += file_line;
-    throw std::runtime_error(message);
+    throw java_problem(message, native_backtrace::capture_shared());
 }
 
 void smjni::internal::do_log_error(const std::exception & ex, const char * format, ...) noexcept
@@ -78,15 +356,7 @@ void smjni::internal::do_log_error(const std::exception & ex, const char * forma
     }
     else
     {
-#ifdef __ANDROID__
-        __android_log_print(ANDROID_LOG_ERROR, "smjni", "%s\n", ex.what());
-        if (format)
-            __android_log_vprint(ANDROID_LOG_ERROR, "smjni", format, vl);
-#else
-        fprintf(stderr, "%s\n", ex.what());
-        if (format)
-            vfprintf(stderr, format, vl);
-#endif
+        get_error_log().log(ex, format, vl);
     }
     va_end(vl);
 }
\ No newline at end of file
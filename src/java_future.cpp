@@ -0,0 +1,76 @@
+/*
+ Copyright 2019 SmJNI Contributors
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include "stdpch.h"
+
+#include <smjni/java_future.h>
+
+using namespace smjni;
+
+java_completion * java_completion::s_instance = nullptr;
+
+java_completion::completion_class::completion_class(JNIEnv * env):
+    simple_java_class(env),
+    m_ctor(env, *this)
+{
+    JNINativeMethod methods[] = {
+        bind_native("complete", complete)
+    };
+    register_natives(env, methods);
+}
+
+void JNICALL java_completion::completion_class::complete(JNIEnv * env, jclass, jlong handle, jobject result, jthrowable error)
+{
+    std::unique_ptr<java_completion_callback> callback(reinterpret_cast<java_completion_callback *>(intptr_t(handle)));
+    callback->on_complete(env, result, error);
+}
+
+java_completion::java_completion(JNIEnv * env):
+    m_future(env),
+    m_completion(env)
+{}
+
+void java_completion::init(JNIEnv * env)
+{
+    s_instance = new java_completion(env);
+}
+
+void java_completion::term()
+{
+    delete s_instance;
+    s_instance = nullptr;
+}
+
+void java_completion::listen(JNIEnv * env, const auto_java_ref<jCompletableFuture> & future,
+                             std::unique_ptr<java_completion_callback> callback)
+{
+    if (!future)
+        THROW_JAVA_PROBLEM("cannot listen to a null future");
+
+    auto completion = s_instance->m_completion.ctor(env, jlong(intptr_t(callback.get())));
+    //From now on the Java object owns the callback and releases it when it is invoked.
+    //whenComplete only fails before registering (or running) the action so on failure we still own it
+    java_completion_callback * raw = callback.release();
+    try
+    {
+        s_instance->m_future.when_complete(env, future, completion);
+    }
+    catch(...)
+    {
+        delete raw;
+        throw;
+    }
+}
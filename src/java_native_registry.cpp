@@ -0,0 +1,53 @@
+/*
+ Copyright 2019 SmJNI Contributors
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include "stdpch.h"
+
+#include <smjni/java_native_registry.h>
+#include <smjni/java_frame.h>
+
+using namespace smjni;
+
+std::vector<java_natives_timing> internal::register_native_classes(JNIEnv * env, const java_native_class_entry * entries, size_t count)
+{
+    using std::chrono::steady_clock;
+
+    std::vector<java_natives_timing> ret;
+    ret.reserve(count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        //releases the class reference and whatever else loading created before the next class
+        java_frame frame(env, 4);
+        const java_native_class_entry & entry = entries[i];
+
+        auto start = steady_clock::now();
+        jclass clazz = entry.load(env);
+        auto loaded = steady_clock::now();
+
+        jint res = env->RegisterNatives(clazz, entry.methods, entry.method_count);
+        if (res != 0)
+        {
+            java_exception::check(env);
+            THROW_JAVA_PROBLEM("unable to register native methods of %s, error %d", entry.name, res);
+        }
+        auto registered = steady_clock::now();
+        entry.registered->store(true, std::memory_order_release);
+
+        ret.push_back({entry.name, loaded - start, registered - loaded, entry.method_count});
+    }
+    return ret;
+}
@@ -23,9 +23,34 @@ java_runtime * java_runtime::s_instance = nullptr;
 
 java_runtime::java_runtime(JNIEnv * jenv):
     m_object(jenv),
-    m_throwable(jenv)
+    m_throwable(jenv),
+    m_out_of_memory_error(preallocate_error(jenv, "java/lang/OutOfMemoryError")),
+    m_stack_overflow_error(preallocate_error(jenv, "java/lang/StackOverflowError"))
 {}
 
+global_java_ref<jthrowable> java_runtime::preallocate_error(JNIEnv * jenv, const char * class_name)
+{
+    auto clazz = jattach(jenv, jenv->FindClass(class_name));
+    if (!clazz)
+    {
+        jenv->ExceptionClear();
+        THROW_JAVA_PROBLEM("failed to locate %s", class_name);
+    }
+    jmethodID ctor = jenv->GetMethodID(clazz.c_ptr(), "<init>", "()V");
+    if (!ctor)
+    {
+        java_exception::check(jenv);
+        THROW_JAVA_PROBLEM("no default constructor in %s", class_name);
+    }
+    auto ret = jattach(jenv, static_cast<jthrowable>(jenv->NewObject(clazz.c_ptr(), ctor)));
+    if (!ret)
+    {
+        java_exception::check(jenv);
+        THROW_JAVA_PROBLEM("unable to create %s", class_name);
+    }
+    return ret;
+}
+
 void java_runtime::init(JNIEnv * env)
 {
     s_instance = new java_runtime(env);
@@ -34,6 +59,7 @@ void java_runtime::init(JNIEnv * env)
 void java_runtime::term()
 {
     delete s_instance;
+    s_instance = nullptr;
 }
 
 
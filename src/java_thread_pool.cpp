@@ -0,0 +1,156 @@
+/*
+ Copyright 2019 SmJNI Contributors
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include "stdpch.h"
+
+#include <smjni/java_thread_pool.h>
+
+using namespace smjni;
+
+static thread_local java_thread_pool * g_current_pool = nullptr;
+static thread_local size_t g_current_index = 0;
+
+java_thread_pool::java_thread_pool(unsigned thread_count, const char * name_prefix)
+{
+    if (thread_count == 0)
+        THROW_JAVA_PROBLEM("thread pool must have at least one thread");
+
+    m_queues.reserve(thread_count);
+    for (unsigned i = 0; i < thread_count; ++i)
+        m_queues.emplace_back(std::make_unique<worker_queue>());
+
+    std::vector<std::promise<void>> started(thread_count);
+    m_threads.reserve(thread_count);
+    try
+    {
+        for (unsigned i = 0; i < thread_count; ++i)
+        {
+            std::string name = name_prefix;
+            name += '-';
+            name += std::to_string(i);
+            m_threads.emplace_back(&java_thread_pool::run, this, i, std::move(name), std::ref(started[i]));
+        }
+        for (auto & promise: started)
+            promise.get_future().get();
+    }
+    catch(...)
+    {
+        stop();
+        throw;
+    }
+}
+
+java_thread_pool::~java_thread_pool() noexcept
+{
+    stop();
+}
+
+void java_thread_pool::stop() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(m_wait_mutex);
+        m_stopping = true;
+    }
+    m_wakeup.notify_all();
+    for (auto & thread: m_threads)
+    {
+        if (thread.joinable())
+            thread.join();
+    }
+}
+
+void java_thread_pool::push(std::unique_ptr<task> new_task)
+{
+    size_t index = (g_current_pool == this) ? g_current_index :
+                                              m_next_queue.fetch_add(1, std::memory_order_relaxed) % m_queues.size();
+    //count first so that the pending count never drops below the number of queued tasks
+    {
+        std::lock_guard<std::mutex> lock(m_wait_mutex);
+        m_pending.fetch_add(1, std::memory_order_relaxed);
+    }
+    {
+        auto & queue = *m_queues[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(new_task));
+    }
+    m_wakeup.notify_one();
+}
+
+bool java_thread_pool::pop(size_t index, std::unique_ptr<task> & dest)
+{
+    //own queue is LIFO for locality, others are stolen from FIFO
+    {
+        auto & queue = *m_queues[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty())
+        {
+            dest = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            m_pending.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    for (size_t i = 1; i < m_queues.size(); ++i)
+    {
+        auto & queue = *m_queues[(index + i) % m_queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty())
+        {
+            dest = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            m_pending.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void java_thread_pool::run(size_t index, std::string name, std::promise<void> & started)
+{
+    JNIEnv * env;
+    try
+    {
+        env = jni_provider::attach_current_thread(name.c_str());
+        started.set_value();
+    }
+    catch(...)
+    {
+        started.set_exception(std::current_exception());
+        return;
+    }
+
+    g_current_pool = this;
+    g_current_index = index;
+
+    for ( ; ; )
+    {
+        std::unique_ptr<task> current;
+        if (pop(index, current))
+        {
+            current->run(env);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_wait_mutex);
+        m_wakeup.wait(lock, [this] () {
+            return m_stopping || m_pending.load(std::memory_order_relaxed) != 0;
+        });
+        if (m_stopping && m_pending.load(std::memory_order_relaxed) == 0)
+            break;
+    }
+
+    g_current_pool = nullptr;
+}
@@ -0,0 +1,243 @@
+/*
+ Copyright 2019 SmJNI Contributors
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include "stdpch.h"
+
+#if defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <dlfcn.h>
+#endif
+
+#include <stdexcept>
+
+#include <smjni/java_vm_host.h>
+#include <smjni/java_runtime.h>
+#include <smjni/java_future.h>
+#include <smjni/java_exception_dispatcher.h>
+#include <smjni/java_exception_translator.h>
+#include <smjni/java_externals.h>
+
+using namespace smjni;
+
+namespace
+{
+    typedef jint (JNICALL * create_vm_func)(JavaVM **, void **, void *);
+    typedef jint (JNICALL * get_created_vms_func)(JavaVM **, jsize, jsize *);
+
+    struct vm_entry_points
+    {
+        create_vm_func create;
+        get_created_vms_func get_created;
+    };
+
+    //Resolved at runtime, like the java launcher does, so that the library itself
+    //never has a link time dependency on libjvm
+    vm_entry_points load_vm(const std::string & path)
+    {
+    #if defined(_WIN32)
+        HMODULE handle = path.empty() ? GetModuleHandleW(L"jvm.dll") : LoadLibraryA(path.c_str());
+        if (!handle)
+            THROW_JAVA_PROBLEM("unable to load JVM library %s, error %lu", path.empty() ? "jvm.dll" : path.c_str(), GetLastError());
+        vm_entry_points ret = {
+            (create_vm_func)GetProcAddress(handle, "JNI_CreateJavaVM"),
+            (get_created_vms_func)GetProcAddress(handle, "JNI_GetCreatedJavaVMs")
+        };
+    #else
+        //RTLD_DEFAULT may be a null pointer so it cannot be checked like a dlopen result
+        void * handle = RTLD_DEFAULT;
+        if (!path.empty() && !(handle = dlopen(path.c_str(), RTLD_NOW | RTLD_GLOBAL)))
+            THROW_JAVA_PROBLEM("unable to load JVM library %s: %s", path.c_str(), dlerror());
+        vm_entry_points ret = {
+            (create_vm_func)dlsym(handle, "JNI_CreateJavaVM"),
+            (get_created_vms_func)dlsym(handle, "JNI_GetCreatedJavaVMs")
+        };
+    #endif
+        if (!ret.create || !ret.get_created)
+            THROW_JAVA_PROBLEM("JNI_CreateJavaVM is not available, specify jvm_library or link with the JVM");
+        return ret;
+    }
+
+    std::string size_option(const char * prefix, size_t size)
+    {
+        char buf[64];
+        if (size % (size_t(1) << 30) == 0)
+            snprintf(buf, sizeof(buf), "%s%zug", prefix, size >> 30);
+        else if (size % (size_t(1) << 20) == 0)
+            snprintf(buf, sizeof(buf), "%s%zum", prefix, size >> 20);
+        else if (size % (size_t(1) << 10) == 0)
+            snprintf(buf, sizeof(buf), "%s%zuk", prefix, size >> 10);
+        else
+            snprintf(buf, sizeof(buf), "%s%zu", prefix, size);
+        return buf;
+    }
+
+    bool g_vm_created = false;
+}
+
+std::vector<std::string> java_vm_options::to_vm_options() const
+{
+    std::vector<std::string> ret;
+
+    if (!class_path.empty())
+    {
+    #if defined(_WIN32)
+        const char separator = ';';
+    #else
+        const char separator = ':';
+    #endif
+        std::string option = "-Djava.class.path=";
+        for (size_t i = 0; i < class_path.size(); ++i)
+        {
+            if (i != 0)
+                option += separator;
+            option += class_path[i];
+        }
+        ret.push_back(std::move(option));
+    }
+
+    if (initial_heap)
+        ret.push_back(size_option("-Xms", initial_heap));
+    if (max_heap)
+        ret.push_back(size_option("-Xmx", max_heap));
+
+    switch(gc)
+    {
+    case java_gc::vm_default:
+        break;
+    case java_gc::serial:
+        ret.push_back("-XX:+UseSerialGC");
+        break;
+    case java_gc::parallel:
+        ret.push_back("-XX:+UseParallelGC");
+        break;
+    case java_gc::g1:
+        ret.push_back("-XX:+UseG1GC");
+        break;
+    case java_gc::z:
+        ret.push_back("-XX:+UseZGC");
+        break;
+    case java_gc::shenandoah:
+        ret.push_back("-XX:+UseShenandoahGC");
+        break;
+    case java_gc::epsilon:
+        ret.push_back("-XX:+UnlockExperimentalVMOptions");
+        ret.push_back("-XX:+UseEpsilonGC");
+        break;
+    }
+
+    if (check_jni)
+        ret.push_back("-Xcheck:jni");
+
+    switch(cds)
+    {
+    case java_cds_mode::vm_default:
+        break;
+    case java_cds_mode::off:
+        ret.push_back("-Xshare:off");
+        break;
+    case java_cds_mode::automatic:
+        ret.push_back("-Xshare:auto");
+        break;
+    case java_cds_mode::required:
+        ret.push_back("-Xshare:on");
+        break;
+    }
+    if (!shared_archive.empty())
+        ret.push_back("-XX:SharedArchiveFile=" + shared_archive);
+    if (!archive_at_exit.empty())
+        ret.push_back("-XX:ArchiveClassesAtExit=" + archive_at_exit);
+
+    ret.insert(ret.end(), extra.begin(), extra.end());
+    return ret;
+}
+
+java_vm_host::java_vm_host(const java_vm_options & options)
+{
+    using std::chrono::steady_clock;
+
+    auto start = steady_clock::now();
+    vm_entry_points entry_points = load_vm(options.jvm_library);
+    auto loaded = steady_clock::now();
+    m_timing.load_library = loaded - start;
+
+    JavaVM * existing = nullptr;
+    jsize existing_count = 0;
+    if (g_vm_created || (entry_points.get_created(&existing, 1, &existing_count) == JNI_OK && existing_count != 0))
+        THROW_JAVA_PROBLEM("a Java VM has already been created in this process");
+
+    std::vector<std::string> option_strings = options.to_vm_options();
+    std::vector<JavaVMOption> vm_options(option_strings.size());
+    for (size_t i = 0; i < option_strings.size(); ++i)
+    {
+        vm_options[i].optionString = &option_strings[i][0];
+        vm_options[i].extraInfo = nullptr;
+    }
+
+    JavaVMInitArgs args;
+    args.version = options.version;
+    args.nOptions = jint(vm_options.size());
+    args.options = vm_options.empty() ? nullptr : &vm_options[0];
+    args.ignoreUnrecognized = options.ignore_unrecognized ? JNI_TRUE : JNI_FALSE;
+
+    jint res = entry_points.create(&m_vm, reinterpret_cast<void **>(&m_env), &args);
+    if (res != JNI_OK)
+        THROW_JAVA_PROBLEM("failed to create Java VM, error %d", res);
+    g_vm_created = true;
+    auto created = steady_clock::now();
+    m_timing.create_vm = created - loaded;
+
+    try
+    {
+        jni_provider::init(m_vm);
+        jni_provider::seed(m_env);
+        java_runtime::init(m_env);
+    }
+    catch(...)
+    {
+        destroy();
+        throw;
+    }
+    m_timing.runtime_init = steady_clock::now() - created;
+}
+
+java_vm_host::~java_vm_host() noexcept
+{
+    destroy();
+}
+
+void java_vm_host::destroy() noexcept
+{
+    //Their cached envs and thread local references would outlive the VM
+    if (size_t attached = jni_provider::attached_threads())
+    {
+        internal::do_log_error(std::logic_error("threads still attached"), 
+                               "%zu threads attached by smjni are still running while the Java VM is destroyed", attached);
+        std::terminate();
+    }
+
+    java_exception_dispatcher::install(nullptr);
+    java_exception_translator::clear();
+    java_completion::term();
+    for (auto it = m_class_tables.rbegin(); it != m_class_tables.rend(); ++it)
+        (*it)();
+    m_class_tables.clear();
+
+    java_runtime::term();
+
+    m_vm->DestroyJavaVM();
+    jni_provider::term();
+}
@@ -17,34 +17,80 @@
 
 #include "stdpch.h"
 
+#include <atomic>
+
 #include <smjni/jni_provider.h>
 #include <smjni/java_externals.h>
 
+#ifndef _WIN32
+    #include <pthread.h>
+#endif
+
 using namespace smjni;
 
 namespace smjni
 {
     namespace internal
     {
-        class jni_record
+        jni_provider * g_provider = nullptr;
+        
+        static std::atomic<size_t> g_attached_threads{0};
+        static thread_local bool g_attached_here = false;
+        
+        static void detach_current_thread()
+        {
+            g_attached_threads.fetch_sub(1, std::memory_order_acq_rel);
+            if (g_provider)
+                g_provider->vm()->DetachCurrentThread();
+        }
+        
+#ifndef _WIN32
+        //A pthread key destructor rather than a thread_local object so that nothing
+        //with a non-trivial destructor lives in TLS and the fast path stays a plain load
+        static pthread_key_t g_detach_key;
+        static pthread_once_t g_detach_key_once = PTHREAD_ONCE_INIT;
+        
+        static void create_detach_key()
+        {
+            pthread_key_create(&g_detach_key, [] (void *) {
+                detach_current_thread();
+            });
+        }
+        
+        static void detach_on_thread_exit()
+        {
+            pthread_once(&g_detach_key_once, create_detach_key);
+            pthread_setspecific(g_detach_key, g_provider);
+            g_attached_threads.fetch_add(1, std::memory_order_acq_rel);
+            g_attached_here = true;
+        }
+#else
+        class thread_detacher
         {
         public:
-            jni_record();
-            ~jni_record();
-
-            JNIEnv * env() const noexcept
-                { return m_env; }
+            ~thread_detacher()
+            {
+                if (m_attached)
+                    detach_current_thread();
+            }
+            
+            void arm() noexcept
+                { m_attached = true; }
         private:
-            JNIEnv * m_env;
-            bool m_attached;
+            bool m_attached = false;
         };
-
-        jni_provider * g_provider = nullptr;
+        
+        static void detach_on_thread_exit()
+        {
+            static thread_local thread_detacher detacher;
+            detacher.arm();
+            g_attached_threads.fetch_add(1, std::memory_order_acq_rel);
+            g_attached_here = true;
+        }
+#endif
     }
 }
 
-thread_local std::unique_ptr<internal::jni_record> jni_provider::m_record;
-
 void jni_provider::init(JNIEnv * initialEnv)
 {
     if (internal::g_provider)
@@ -65,47 +111,44 @@ void jni_provider::init(JavaVM * vm)
     internal::g_provider = new jni_provider(vm);
 }
 
-JNIEnv * jni_provider::get_jni()
-{ 
-    internal::jni_record * ptr = m_record.get();
-    if (!ptr)
-    {
-        ptr = new internal::jni_record;
-        m_record.reset(ptr);
-    }
-    return ptr->env();
+void jni_provider::term() noexcept
+{
+    delete internal::g_provider;
+    internal::g_provider = nullptr;
+    s_env = nullptr;
 }
 
 template<typename T>
 T ** AttachCurrentThreadAsDaemonOutputTypeDetector(jint (JavaVM::*)(T **, void *));
 
-internal::jni_record::jni_record():
-    m_env(nullptr),
-    m_attached(false)
+JNIEnv * jni_provider::attach_current_thread(const char * name)
 { 
-    JavaVM * vm = g_provider->vm();
+    if (!internal::g_provider)
+        THROW_JAVA_PROBLEM("no Java VM, jni_provider is not initialized or was terminated");
+    JavaVM * vm = internal::g_provider->vm();
 
-    jint get_res = vm->GetEnv(reinterpret_cast<void**>(&m_env), JNI_VERSION_1_6);
+    JNIEnv * env = nullptr;
+    jint get_res = vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6);
     if (get_res != JNI_OK)
     {
         JavaVMAttachArgs args = {
             JNI_VERSION_1_6,
-            nullptr,
+            const_cast<char *>(name),
             nullptr
         };
 
         using env_ret_type = decltype(AttachCurrentThreadAsDaemonOutputTypeDetector(&JavaVM::AttachCurrentThreadAsDaemon));
-        jint attach_res = vm->AttachCurrentThreadAsDaemon((env_ret_type)&m_env, &args);
+        jint attach_res = vm->AttachCurrentThreadAsDaemon((env_ret_type)&env, &args);
         if (attach_res != JNI_OK)
             THROW_JAVA_PROBLEM("failed to obtain JNIEnv, error %d and failed to attach Java VM to current thread, error %d", get_res, attach_res);
-        m_attached = true;
-    } 
+        internal::detach_on_thread_exit();
+    }
+    s_env = env;
+    return env;
 }
 
-internal::jni_record::~jni_record()
+size_t jni_provider::attached_threads() noexcept
 {
-    if (m_attached && g_provider)
-    {
-        g_provider->vm()->DetachCurrentThread();
-    }
+    size_t ret = internal::g_attached_threads.load(std::memory_order_acquire);
+    return internal::g_attached_here ? ret - 1 : ret;
 }
@@ -0,0 +1,156 @@
+/*
+ Copyright 2019 SmJNI Contributors
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include "stdpch.h"
+
+#if defined(_WIN32)
+    #include <windows.h>
+#elif defined(__ANDROID__)
+    #include <unwind.h>
+    #include <dlfcn.h>
+    #include <cxxabi.h>
+#else
+    #include <execinfo.h>
+    #include <dlfcn.h>
+    #include <cxxabi.h>
+#endif
+
+#include <smjni/native_backtrace.h>
+#include <smjni/java_exception.h>
+
+using namespace smjni;
+
+#if defined(__ANDROID__)
+
+namespace
+{
+    struct unwind_state
+    {
+        void ** current;
+        void ** end;
+        unsigned skip;
+    };
+
+    _Unwind_Reason_Code unwind_callback(struct _Unwind_Context * context, void * arg)
+    {
+        auto state = static_cast<unwind_state *>(arg);
+        uintptr_t pc = _Unwind_GetIP(context);
+        if (!pc)
+            return _URC_NO_REASON;
+        if (state->skip)
+        {
+            --state->skip;
+            return _URC_NO_REASON;
+        }
+        if (state->current == state->end)
+            return _URC_END_OF_STACK;
+        *state->current++ = reinterpret_cast<void *>(pc);
+        return _URC_NO_REASON;
+    }
+}
+
+#endif
+
+void native_backtrace::do_capture(unsigned skip) noexcept
+{
+    ++skip; //this function
+#if defined(_WIN32)
+    m_size = CaptureStackBackTrace(DWORD(skip), max_frames, m_frames, nullptr);
+#elif defined(__ANDROID__)
+    unwind_state state{m_frames, m_frames + max_frames, skip};
+    _Unwind_Backtrace(unwind_callback, &state);
+    m_size = unsigned(state.current - m_frames);
+#else
+    void * frames[max_frames + 8];
+    int count = backtrace(frames, int(std::size(frames)));
+    if (count <= int(skip))
+        return;
+    m_size = std::min(unsigned(count) - skip, max_frames);
+    std::copy(frames + skip, frames + skip + m_size, m_frames);
+#endif
+}
+
+std::shared_ptr<const native_backtrace> native_backtrace::do_capture_shared(unsigned skip) noexcept
+{
+    try
+    {
+        auto ret = std::make_shared<native_backtrace>();
+        ret->do_capture(skip + 1); //this function
+        return ret;
+    }
+    catch(std::bad_alloc &)
+    {
+        return nullptr;
+    }
+}
+
+const native_backtrace * native_backtrace::of(const std::exception & ex) noexcept
+{
+    if (auto problem = dynamic_cast<const java_problem *>(&ex))
+        return problem->backtrace();
+    if (auto java_ex = dynamic_cast<const java_exception *>(&ex))
+        return java_ex->backtrace();
+    return nullptr;
+}
+
+std::vector<native_backtrace::frame> native_backtrace::symbolize() const
+{
+    std::vector<frame> ret;
+    ret.reserve(m_size);
+    for (unsigned i = 0; i < m_size; ++i)
+    {
+        frame current{m_frames[i], std::string(), std::string(), reinterpret_cast<uintptr_t>(m_frames[i])};
+#if defined(_WIN32)
+        HMODULE module = nullptr;
+        if (GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                               static_cast<LPCSTR>(m_frames[i]), &module))
+        {
+            char path[MAX_PATH];
+            DWORD len = GetModuleFileNameA(module, path, MAX_PATH);
+            current.module.assign(path, len);
+            current.offset -= reinterpret_cast<uintptr_t>(module);
+        }
+#else
+        Dl_info info;
+        if (dladdr(m_frames[i], &info))
+        {
+            if (info.dli_fname)
+                current.module = info.dli_fname;
+            if (info.dli_sname)
+            {
+                int status = 0;
+                char * demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+                current.symbol = (status == 0 && demangled) ? demangled : info.dli_sname;
+                free(demangled);
+                current.offset -= reinterpret_cast<uintptr_t>(info.dli_saddr);
+            }
+            else
+            {
+                current.offset -= reinterpret_cast<uintptr_t>(info.dli_fbase);
+            }
+        }
+#endif
+        ret.push_back(std::move(current));
+    }
+    return ret;
+}
+
+std::future<std::vector<native_backtrace::frame>> native_backtrace::symbolize_async() const
+{
+    return std::async(std::launch::async, [copy = *this] () {
+        return copy.symbolize();
+    });
+}
@@ -0,0 +1,93 @@
+/*
+ Copyright 2019 SmJNI Contributors
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include "stdpch.h"
+
+#include <smjni/native_peer.h>
+
+using namespace smjni;
+using namespace smjni::internal;
+
+native_peer_table::~native_peer_table() noexcept
+{
+    for (auto & chunk: m_chunks)
+        delete[] chunk.load(std::memory_order_relaxed);
+}
+
+jlong native_peer_table::add(void * ptr)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    uint32_t index;
+    if (!m_free.empty())
+    {
+        index = m_free.back();
+        m_free.pop_back();
+    }
+    else
+    {
+        if (m_used == s_max_chunks * s_chunk_size)
+            THROW_JAVA_PROBLEM("too many native peers");
+        index = m_used;
+        auto & chunk = m_chunks[index >> s_chunk_bits];
+        if (!chunk.load(std::memory_order_relaxed))
+            chunk.store(new slot[s_chunk_size], std::memory_order_release);
+        ++m_used;
+    }
+
+    slot & entry = m_chunks[index >> s_chunk_bits].load(std::memory_order_relaxed)[index & (s_chunk_size - 1)];
+    entry.ptr.store(ptr, std::memory_order_release);
+    uint32_t generation = entry.generation.load(std::memory_order_relaxed);
+    return jlong((uint64_t(index) << 32) | generation);
+}
+
+void * native_peer_table::remove(jlong handle) noexcept
+{
+    if (!handle)
+        return nullptr;
+
+    uint64_t value = uint64_t(handle);
+    uint32_t index = uint32_t(value >> 32);
+    uint32_t generation = uint32_t(value);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (index >= m_used)
+        return nullptr;
+    slot & entry = m_chunks[index >> s_chunk_bits].load(std::memory_order_relaxed)[index & (s_chunk_size - 1)];
+    if (entry.generation.load(std::memory_order_relaxed) != generation)
+        return nullptr;
+
+    uint32_t next = generation + 1;
+    if (next == 0) //0 is never a valid generation so that a handle is never 0
+        next = 1;
+    entry.generation.store(next, std::memory_order_release);
+    void * ret = entry.ptr.exchange(nullptr, std::memory_order_release);
+    try
+    {
+        m_free.push_back(index);
+    }
+    catch(std::bad_alloc &)
+    {
+        //the slot is simply never reused
+    }
+    return ret;
+}
+
+void native_peer_table::throw_dangling(const char * name)
+{
+    THROW_JAVA_PROBLEM("native peer in field %s is not attached or has been detached", name ? name : "");
+}
@@ -0,0 +1,592 @@
+/*
+ Copyright 2019 SmJNI Contributors
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <smjni/smjni.h>
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <iterator>
+#include <string>
+#include <utility>
+
+using namespace smjni;
+
+DEFINE_JAVA_TYPE(jBenchTarget, "smjni.tests.BenchTarget")
+DEFINE_JAVA_TYPE(jBenchTargetSnapshot, "smjni.tests.BenchTargetSnapshot")
+DEFINE_JAVA_TYPE(jRuntimeException, "java.lang.RuntimeException")
+DEFINE_JAVA_TYPE(jIllegalStateException, "java.lang.IllegalStateException")
+DEFINE_JAVA_TYPE(jIllegalArgumentException, "java.lang.IllegalArgumentException")
+
+//Mirrors what jnigen generates for @ExposeToNative(inlineAccessors = true)
+namespace BenchTarget_inline
+{
+    namespace ids
+    {
+        inline java_id_slot<jmethodID> call1;
+    }
+
+    inline jint call1(JNIEnv * env, jBenchTarget self, jint a1)
+        { return internal::call_java_method<jint, jBenchTarget, jint>(env, ids::call1.get(), self, a1); }
+}
+
+class BenchTarget : public java_runtime::simple_java_class<jBenchTarget>
+{
+public:
+    BenchTarget(JNIEnv * env):
+        simple_java_class(env),
+        ctor(env, *this),
+        value(env, *this, "value"),
+        size(env, *this, "size"),
+        weight(env, *this, "weight"),
+        snapshot(env),
+        self(env, *this, "self"),
+        staticCall0(env, *this, "staticCall0"),
+        call0(env, *this, "call0"),
+        call1(env, *this, "call1"),
+        call2(env, *this, "call2"),
+        call3(env, *this, "call3"),
+        call4(env, *this, "call4"),
+        call5(env, *this, "call5"),
+        call6(env, *this, "call6"),
+        call7(env, *this, "call7"),
+        call8(env, *this, "call8")
+    {
+        BenchTarget_inline::ids::call1.set(java_method_id<instance_method, jint, jint>(env, *this, "call1").get());
+    }
+
+    const java_constructor<jBenchTarget> ctor;
+    const java_field<jint, jBenchTarget> value;
+    const java_field<jlong, jBenchTarget> size;
+    const java_field<jdouble, jBenchTarget> weight;
+    const java_field_snapshot<jBenchTarget, jBenchTargetSnapshot, 3> snapshot;
+    const java_method<jBenchTarget, jBenchTarget> self;
+    const java_static_method<jint, jBenchTarget> staticCall0;
+    const java_method<jint, jBenchTarget> call0;
+    const java_method<jint, jBenchTarget, jint> call1;
+    const java_method<jint, jBenchTarget, jint, jint> call2;
+    const java_method<jint, jBenchTarget, jint, jint, jint> call3;
+    const java_method<jint, jBenchTarget, jint, jint, jint, jint> call4;
+    const java_method<jint, jBenchTarget, jint, jint, jint, jint, jint> call5;
+    const java_method<jint, jBenchTarget, jint, jint, jint, jint, jint, jint> call6;
+    const java_method<jint, jBenchTarget, jint, jint, jint, jint, jint, jint, jint> call7;
+    const java_method<jint, jBenchTarget, jint, jint, jint, jint, jint, jint, jint, jint> call8;
+};
+
+typedef java_runtime::simple_java_class<jRuntimeException> RuntimeException;
+typedef java_runtime::simple_java_class<jIllegalStateException> IllegalStateException;
+typedef java_runtime::simple_java_class<jIllegalArgumentException> IllegalArgumentException;
+
+typedef java_class_table<BenchTarget, RuntimeException, IllegalStateException, IllegalArgumentException> bench_classes;
+
+namespace
+{
+    JavaVM * g_vm = nullptr;
+
+    std::string make_ascii(size_t size)
+    {
+        std::string ret(size, ' ');
+        for (size_t i = 0; i < size; ++i)
+            ret[i] = char('a' + i % 26);
+        return ret;
+    }
+
+    //Call a callN method with N int arguments through smjni or directly
+    template<size_t Arity, typename Method, size_t... Idx>
+    jint call_wrapped(JNIEnv * env, const Method & method, jBenchTarget obj, std::index_sequence<Idx...>)
+    {
+        return method(env, obj, jint(Idx)...);
+    }
+
+    template<size_t Arity, size_t... Idx>
+    jint call_raw(JNIEnv * env, jmethodID id, jobject obj, std::index_sequence<Idx...>)
+    {
+        jint ret = env->CallIntMethod(obj, id, jint(Idx)...);
+        if (env->ExceptionCheck())
+            std::abort();
+        return ret;
+    }
+
+    template<size_t Arity>
+    const auto & method_of_arity(const BenchTarget & target)
+    {
+        if constexpr (Arity == 0) return target.call0;
+        else if constexpr (Arity == 1) return target.call1;
+        else if constexpr (Arity == 2) return target.call2;
+        else if constexpr (Arity == 3) return target.call3;
+        else if constexpr (Arity == 4) return target.call4;
+        else if constexpr (Arity == 5) return target.call5;
+        else if constexpr (Arity == 6) return target.call6;
+        else if constexpr (Arity == 7) return target.call7;
+        else return target.call8;
+    }
+
+    template<size_t Arity>
+    std::string raw_signature()
+    {
+        std::string ret = "(";
+        ret.append(Arity, 'I');
+        ret += ")I";
+        return ret;
+    }
+}
+
+//Strings
+
+static void BM_StringCreate_Raw(benchmark::State & state)
+{
+    JNIEnv * env = jni_provider::get_jni();
+    std::string str = make_ascii(size_t(state.range(0)));
+    for (auto _ : state)
+    {
+        jstring res = env->NewStringUTF(str.c_str());
+        benchmark::DoNotOptimize(res);
+        env->DeleteLocalRef(res);
+    }
+}
+BENCHMARK(BM_StringCreate_Raw)->Arg(16)->Arg(256)->Arg(4096);
+
+static void BM_StringCreate(benchmark::State & state)
+{
+    JNIEnv * env = jni_provider::get_jni();
+    std::string str = make_ascii(size_t(state.range(0)));
+    for (auto _ : state)
+    {
+        auto res = java_string_create(env, str);
+        benchmark::DoNotOptimize(res.c_ptr());
+    }
+}
+BENCHMARK(BM_StringCreate)->Arg(16)->Arg(256)->Arg(4096);
+
+static void BM_StringToCpp_Raw(benchmark::State & state)
+{
+    JNIEnv * env = jni_provider::get_jni();
+    auto str = java_string_create(env, make_ascii(size_t(state.range(0))));
+    for (auto _ : state)
+    {
+        jsize len = env->GetStringLength(str.c_ptr());
+        std::string res(size_t(env->GetStringUTFLength(str.c_ptr())), '\0');
+        env->GetStringUTFRegion(str.c_ptr(), 0, len, &res[0]);
+        benchmark::DoNotOptimize(res.data());
+    }
+}
+BENCHMARK(BM_StringToCpp_Raw)->Arg(16)->Arg(256)->Arg(4096);
+
+static void BM_StringToCpp(benchmark::State & state)
+{
+    JNIEnv * env = jni_provider::get_jni();
+    auto str = java_string_create(env, make_ascii(size_t(state.range(0))));
+    for (auto _ : state)
+    {
+        std::string res = java_string_to_cpp(env, str);
+        benchmark::DoNotOptimize(res.data());
+    }
+}
+BENCHMARK(BM_StringToCpp)->Arg(16)->Arg(256)->Arg(4096);
+
+//Arrays
+
+static void BM_ArrayAccess_Raw(benchmark::State & state)
+{
+    JNIEnv * env = jni_provider::get_jni();
+    auto array = java_array_create<jint>(env, jsize(state.range(0)));
+    for (auto _ : state)
+    {
+        jint * data = env->GetIntArrayElements(array.c_ptr(), nullptr);
+        jint sum = 0;
+        for (jsize i = 0, count = env->GetArrayLength(array.c_ptr()); i < count; ++i)
+            sum += data[i];
+        benchmark::DoNotOptimize(sum);
+        env->ReleaseIntArrayElements(array.c_ptr(), data, JNI_ABORT);
+    }
+}
+BENCHMARK(BM_ArrayAccess_Raw)->Arg(16)->Arg(4096);
+
+static void BM_ArrayAccess(benchmark::State & state)
+{
+    JNIEnv * env = jni_provider::get_jni();
+    auto array = java_array_create<jint>(env, jsize(state.range(0)));
+    for (auto _ : state)
+    {
+        java_array_access access(env, array);
+        jint sum = 0;
+        for (jint val: access)
+            sum += val;
+        benchmark::DoNotOptimize(sum);
+    }
+}
+BENCHMARK(BM_ArrayAccess)->Arg(16)->Arg(4096);
+
+//Method calls
+
+template<size_t Arity>
+static void BM_Call_Raw(benchmark::State & state)
+{
+    JNIEnv * env = jni_provider::get_jni();
+    auto & target = bench_classes::get<BenchTarget>();
+    auto obj = target.ctor(env, target);
+    std::string name = "call" + std::to_string(Arity);
+    jmethodID id = env->GetMethodID(target.c_ptr(), name.c_str(), raw_signature<Arity>().c_str());
+    for (auto _ : state)
+        benchmark::DoNotOptimize(call_raw<Arity>(env, id, obj.c_ptr(), std::make_index_sequence<Arity>()));
+}
+
+template<size_t Arity>
+static void BM_Call(benchmark::State & state)
+{
+    JNIEnv * env = jni_provider::get_jni();
+    auto & target = bench_classes::get<BenchTarget>();
+    auto obj = target.ctor(env, target);
+    auto & method = method_of_arity<Arity>(target);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(call_wrapped<Arity>(env, method, obj.c_ptr(), std::make_index_sequence<Arity>()));
+}
+
+#define BENCHMARK_ARITY(arity) \
+    BENCHMARK_TEMPLATE(BM_Call_Raw, arity); \
+    BENCHMARK_TEMPLATE(BM_Call, arity)
+
+BENCHMARK_ARITY(0);
+BENCHMARK_ARITY(1);
+BENCHMARK_ARITY(2);
+BENCHMARK_ARITY(3);
+BENCHMARK_ARITY(4);
+BENCHMARK_ARITY(5);
+BENCHMARK_ARITY(6);
+BENCHMARK_ARITY(7);
+BENCHMARK_ARITY(8);
+
+//Looking the class up on every call as code that does not hold on to it does,
+//against the free function loading its id from a constant initialized slot
+
+static void BM_Call_Table(benchmark::State & state)
+{
+    JNIEnv * env = jni_provider::get_jni();
+    auto & target = bench_classes::get<BenchTarget>();
+    auto obj = target.ctor(env, target);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(bench_classes::get<BenchTarget>().call1(env, obj.c_ptr(), 1));
+}
+BENCHMARK(BM_Call_Table);
+
+static void BM_Call_Inline(benchmark::State & state)
+{
+    JNIEnv * env = jni_provider::get_jni();
+    auto & target = bench_classes::get<BenchTarget>();
+    auto obj = target.ctor(env, target);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(BenchTarget_inline::call1(env, obj.c_ptr(), 1));
+}
+BENCHMARK(BM_Call_Inline);
+
+static void BM_StaticCall_Raw(benchmark::State & state)
+{
+    JNIEnv * env = jni_provider::get_jni();
+    auto & target = bench_classes::get<BenchTarget>();
+    jmethodID id = env->GetStaticMethodID(target.c_ptr(), "staticCall0", "()I");
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(env->CallStaticIntMethod(target.c_ptr(), id));
+        if (env->ExceptionCheck())
+            std::abort();
+    }
+}
+BENCHMARK(BM_StaticCall_Raw);
+
+static void BM_StaticCall(benchmark::State & state)
+{
+    JNIEnv * env = jni_provider::get_jni();
+    auto & target = bench_classes::get<BenchTarget>();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(target.staticCall0(env, target));
+}
+BENCHMARK(BM_StaticCall);
+
+//Returning a reference: unique_local_ref vs raw local reference management
+
+static void BM_ReturnObject_Raw(benchmark::State & state)
+{
+    JNIEnv * env = jni_provider::get_jni();
+    auto & target = bench_classes::get<BenchTarget>();
+    auto obj = target.ctor(env, target);
+    jmethodID id = env->GetMethodID(target.c_ptr(), "self", "()Lsmjni/tests/BenchTarget;");
+    for (auto _ : state)
+    {
+        jobject res = env->CallObjectMethod(obj.c_ptr(), id);
+        if (!res)
+            std::abort();
+        benchmark::DoNotOptimize(res);
+        env->DeleteLocalRef(res);
+    }
+}
+BENCHMARK(BM_ReturnObject_Raw);
+
+static void BM_ReturnObject(benchmark::State & state)
+{
+    JNIEnv * env = jni_provider::get_jni();
+    auto & target = bench_classes::get<BenchTarget>();
+    auto obj = target.ctor(env, target);
+    for (auto _ : state)
+    {
+        auto res = target.self(env, obj);
+        benchmark::DoNotOptimize(res.c_ptr());
+    }
+}
+BENCHMARK(BM_ReturnObject);
+
+//Fields
+
+static void BM_FieldGetSet_Raw(benchmark::State & state)
+{
+    JNIEnv * env = jni_provider::get_jni();
+    auto & target = bench_classes::get<BenchTarget>();
+    auto obj = target.ctor(env, target);
+    jfieldID id = env->GetFieldID(target.c_ptr(), "value", "I");
+    for (auto _ : state)
+    {
+        jint val = env->GetIntField(obj.c_ptr(), id);
+        env->SetIntField(obj.c_ptr(), id, val + 1);
+    }
+}
+BENCHMARK(BM_FieldGetSet_Raw);
+
+static void BM_FieldGetSet(benchmark::State & state)
+{
+    JNIEnv * env = jni_provider::get_jni();
+    auto & target = bench_classes::get<BenchTarget>();
+    auto obj = target.ctor(env, target);
+    for (auto _ : state)
+    {
+        jint val = target.value.get(env, obj);
+        target.value.set(env, obj, val + 1);
+    }
+}
+BENCHMARK(BM_FieldGetSet);
+
+//Three fields one JNI call each versus one snapshot call each way through a reused buffer
+
+static void BM_FieldSnapshot_PerField(benchmark::State & state)
+{
+    JNIEnv * env = jni_provider::get_jni();
+    auto & target = bench_classes::get<BenchTarget>();
+    auto obj = target.ctor(env, target);
+    for (auto _ : state)
+    {
+        jint val = target.value.get(env, obj);
+        jlong size = target.size.get(env, obj);
+        jdouble weight = target.weight.get(env, obj);
+        target.value.set(env, obj, val + 1);
+        target.size.set(env, obj, size + 1);
+        target.weight.set(env, obj, weight + 1);
+    }
+}
+BENCHMARK(BM_FieldSnapshot_PerField);
+
+static void BM_FieldSnapshot(benchmark::State & state)
+{
+    JNIEnv * env = jni_provider::get_jni();
+    auto & target = bench_classes::get<BenchTarget>();
+    auto obj = target.ctor(env, target);
+    java_snapshot_buffer<3> buffer(env);
+    for (auto _ : state)
+    {
+        jlong slots[3];
+        target.snapshot.read(env, obj, buffer, slots);
+        const jlong updated[] = {
+            internal::to_snapshot_slot(internal::from_snapshot_slot<jint>(slots[0]) + 1),
+            internal::to_snapshot_slot(internal::from_snapshot_slot<jlong>(slots[1]) + 1),
+            internal::to_snapshot_slot(internal::from_snapshot_slot<jdouble>(slots[2]) + 1)
+        };
+        target.snapshot.write(env, obj, buffer, updated);
+    }
+}
+BENCHMARK(BM_FieldSnapshot);
+
+//Global references
+
+static void BM_GlobalRefChurn_Raw(benchmark::State & state)
+{
+    JNIEnv * env = jni_provider::get_jni();
+    auto & target = bench_classes::get<BenchTarget>();
+    auto obj = target.ctor(env, target);
+    for (auto _ : state)
+    {
+        jobject ref = env->NewGlobalRef(obj.c_ptr());
+        benchmark::DoNotOptimize(ref);
+        env->DeleteGlobalRef(ref);
+    }
+}
+BENCHMARK(BM_GlobalRefChurn_Raw);
+
+static void BM_GlobalRefChurn(benchmark::State & state)
+{
+    JNIEnv * env = jni_provider::get_jni();
+    auto & target = bench_classes::get<BenchTarget>();
+    auto obj = target.ctor(env, target);
+    for (auto _ : state)
+    {
+        global_java_ref<jBenchTarget> ref(obj);
+        benchmark::DoNotOptimize(ref.c_ptr());
+    }
+}
+BENCHMARK(BM_GlobalRefChurn);
+
+//Exception dispatch. The thrown IllegalStateException matches the second of three candidates
+
+namespace
+{
+    class runtime_error : public java_exception
+    {
+    public:
+        using java_exception::java_exception;
+    };
+
+    class illegal_state_error : public runtime_error
+    {
+    public:
+        using runtime_error::runtime_error;
+    };
+
+    class illegal_argument_error : public runtime_error
+    {
+    public:
+        using runtime_error::runtime_error;
+    };
+
+    global_java_ref<jthrowable> make_illegal_state(JNIEnv * env)
+    {
+        jclass clazz = bench_classes::get<IllegalStateException>().c_ptr();
+        jmethodID ctor = env->GetMethodID(clazz, "<init>", "()V");
+        return jattach(env, static_cast<jthrowable>(env->NewObject(clazz, ctor)));
+    }
+}
+
+static void BM_DispatchException_Raw(benchmark::State & state)
+{
+    JNIEnv * env = jni_provider::get_jni();
+    auto ex = make_illegal_state(env);
+    jclass candidates[] = {
+        bench_classes::get<IllegalArgumentException>().c_ptr(),
+        bench_classes::get<IllegalStateException>().c_ptr(),
+        bench_classes::get<RuntimeException>().c_ptr()
+    };
+    for (auto _ : state)
+    {
+        java_frame frame(env, 2);
+        env->Throw(ex.c_ptr());
+        try
+        {
+            java_exception::check(env);
+        }
+        catch(java_exception & caught)
+        {
+            size_t idx = 0;
+            while (idx < std::size(candidates) && !env->IsInstanceOf(caught.throwable(), candidates[idx]))
+                ++idx;
+            benchmark::DoNotOptimize(idx);
+        }
+    }
+}
+BENCHMARK(BM_DispatchException_Raw);
+
+static void BM_DispatchException(benchmark::State & state)
+{
+    JNIEnv * env = jni_provider::get_jni();
+    auto ex = make_illegal_state(env);
+    java_exception_dispatcher dispatcher;
+    dispatcher.add<runtime_error>(bench_classes::get<RuntimeException>());
+    dispatcher.add<illegal_state_error>(bench_classes::get<IllegalStateException>());
+    dispatcher.add<illegal_argument_error>(bench_classes::get<IllegalArgumentException>());
+    java_exception_dispatcher::scoped_install installed(dispatcher);
+    for (auto _ : state)
+    {
+        java_frame frame(env, 2);
+        env->Throw(ex.c_ptr());
+        try
+        {
+            java_exception::check(env);
+        }
+        catch(illegal_state_error & caught)
+        {
+            benchmark::DoNotOptimize(caught.throwable());
+        }
+    }
+}
+BENCHMARK(BM_DispatchException);
+
+//Environment lookup
+
+static void BM_GetEnv_Raw(benchmark::State & state)
+{
+    for (auto _ : state)
+    {
+        JNIEnv * env = nullptr;
+        g_vm->GetEnv((void **)&env, JNI_VERSION_1_6);
+        benchmark::DoNotOptimize(env);
+    }
+}
+BENCHMARK(BM_GetEnv_Raw);
+
+static void BM_GetJni(benchmark::State & state)
+{
+    for (auto _ : state)
+        benchmark::DoNotOptimize(jni_provider::get_jni());
+}
+BENCHMARK(BM_GetJni);
+
+//Native backtraces. Argument is whether capture is enabled
+
+static void BM_BacktraceCapture(benchmark::State & state)
+{
+    native_backtrace::set_enabled(state.range(0) != 0);
+    for (auto _ : state)
+    {
+        auto trace = native_backtrace::capture();
+        benchmark::DoNotOptimize(&trace);
+    }
+    native_backtrace::set_enabled(false);
+}
+BENCHMARK(BM_BacktraceCapture)->Arg(0)->Arg(1);
+
+int main(int argc, char ** argv)
+{
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+
+    java_vm_options options;
+    options.class_path.push_back(SMJNI_BENCH_CLASS_PATH);
+
+    try
+    {
+        java_vm_host host(options);
+        host.init_classes<bench_classes>();
+        g_vm = host.vm();
+
+        auto & timing = host.startup_timing();
+        benchmark::AddCustomContext("vm_startup_ns", std::to_string((timing.load_library + timing.create_vm +
+                                                                     timing.runtime_init + timing.classes_init).count()));
+
+        benchmark::RunSpecifiedBenchmarks();
+    }
+    catch(std::exception & ex)
+    {
+        fprintf(stderr, "%s\n", ex.what());
+        return 1;
+    }
+    benchmark::Shutdown();
+    return 0;
+}
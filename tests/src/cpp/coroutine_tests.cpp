@@ -0,0 +1,100 @@
+/*
+ Copyright 2019 SmJNI Contributors
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+//Compiled as C++20, see CMakeLists.txt
+
+#include <smjni/smjni.h>
+
+#include "catch.hpp"
+
+#include "test_util.h"
+
+#include <future>
+#include <string>
+
+#if !SMJNI_HAS_COROUTINES
+    #error "coroutine tests must be compiled with coroutine support"
+#endif
+
+using namespace smjni;
+
+namespace
+{
+    //Starts eagerly and destroys itself when done
+    struct detached_task
+    {
+        struct promise_type
+        {
+            detached_task get_return_object() noexcept
+                { return {}; }
+            std::suspend_never initial_suspend() noexcept
+                { return {}; }
+            std::suspend_never final_suspend() noexcept
+                { return {}; }
+            void return_void() noexcept
+            {}
+            void unhandled_exception() noexcept
+                { std::terminate(); }
+        };
+    };
+
+    //The future is only used before the first suspension so a raw local reference is fine.
+    //After resumption we may be on another thread and must not use the original env
+    template<typename Executor>
+    detached_task await_string(JNIEnv * env, jCompletableFuture future, Executor executor, std::promise<std::string> & outcome)
+    {
+        try
+        {
+            auto result = co_await java_await(env, jauto(future), executor);
+            JNIEnv * resumed_env = jni_provider::get_jni();
+            outcome.set_value(java_string_to_cpp(resumed_env, jauto(jstatic_cast<jstring>(result.c_ptr()))));
+        }
+        catch(java_exception &)
+        {
+            outcome.set_value("error");
+        }
+    }
+
+    template<typename Executor, typename Future>
+    std::string await_and_wait(JNIEnv * env, const Future & future, Executor executor)
+    {
+        std::promise<std::string> outcome;
+        auto ret = outcome.get_future();
+        await_string(env, jstatic_cast<jCompletableFuture>(future.c_ptr()), executor, outcome);
+        return ret.get();
+    }
+}
+
+TEST_CASE( "testJavaAwaitInline", "[integration]" )
+{
+    JNIEnv * env = jni_provider::get_jni();
+    auto & test_class = java_classes::get<TestSmJNI>();
+
+    CHECK(await_and_wait(env, test_class.completedFuture(env, java_string_create(env, "now")), resume_inline()) == "now");
+    CHECK(await_and_wait(env, test_class.asyncFuture(env, java_string_create(env, "later")), resume_inline()) == "later");
+    CHECK(await_and_wait(env, test_class.failedFuture(env, java_string_create(env, "oops")), resume_inline()) == "error");
+}
+
+TEST_CASE( "testJavaAwaitOnPool", "[integration]" )
+{
+    JNIEnv * env = jni_provider::get_jni();
+    auto & test_class = java_classes::get<TestSmJNI>();
+    java_thread_pool pool(1, "smjni-await");
+
+    CHECK(await_and_wait(env, test_class.completedFuture(env, java_string_create(env, "now")), resume_on_pool(pool)) == "now");
+    CHECK(await_and_wait(env, test_class.asyncFuture(env, java_string_create(env, "later")), resume_on_pool(pool)) == "later");
+    CHECK(await_and_wait(env, test_class.failedFuture(env, java_string_create(env, "oops")), resume_on_pool(pool)) == "error");
+}
@@ -20,6 +20,10 @@
 
 #include "test_util.h"
 
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <future>
 #include <thread>
 
 using namespace smjni;
@@ -34,6 +38,9 @@ jboolean JNICALL TestSmJNI::nativeMethodImplementation(JNIEnv * env, jclass, jbo
                                      jbooleanArray bla, jbyteArray ba, jcharArray ca, jshortArray sa, jintArray ia, jlongArray la, jfloatArray fa, jdoubleArray da, jstringArray stra)
 {
     NATIVE_PROLOG
+        jni_provider::seed(env);
+        CHECK(jni_provider::get_jni() == env);
+
         CHECK(bl);
         CHECK(42 == b);
         CHECK(u'q' == c);
@@ -142,6 +149,633 @@ TEST_CASE( "testCallingJava", "[integration]" )
     anotherThread.join();
 }
 
+static void doTestCallingJavaLazily()
+{
+    JNIEnv * env = jni_provider::get_jni();
+    auto & lazy_class = java_classes::get<Lazy>();
+
+    auto lazy = lazy_class.ctor(env, 42);
+
+    CHECK(42 == lazy_class.get_value(env, lazy));
+    lazy_class.set_value(env, lazy, -42);
+    CHECK(-42 == lazy_class.get_value(env, lazy));
+
+    CHECK(15 == lazy_class.get_staticValue(env));
+    lazy_class.set_staticValue(env, -15);
+    CHECK(-15 == lazy_class.get_staticValue(env));
+    lazy_class.set_staticValue(env, 15);
+
+    CHECK(74 == lazy_class.staticMethod(env, 74));
+
+    CHECK(4 == lazy_class.instanceMethod(env, lazy, 3));
+}
+
+//Only touches members that do not modify shared state so it can run on several threads at once
+static bool doResolveLazily()
+{
+    JNIEnv * env = jni_provider::get_jni();
+    auto & lazy_class = java_classes::get<Lazy>();
+
+    auto lazy = lazy_class.ctor(env, 42);
+    return lazy_class.get_value(env, lazy) == 42 &&
+           lazy_class.get_staticValue(env) == 15 &&
+           lazy_class.staticMethod(env, 74) == 74 &&
+           lazy_class.instanceMethod(env, lazy, 3) == 4;
+}
+
+TEST_CASE( "testCallingJavaLazily", "[integration]" )
+{
+    //concurrent first resolution of the ids shared by the single class instance
+    bool resolved_on_other_thread = false;
+    std::thread anotherThread([&resolved_on_other_thread] () {
+        resolved_on_other_thread = doResolveLazily();
+    });
+    bool resolved = doResolveLazily();
+    anotherThread.join();
+    CHECK(resolved);
+    CHECK(resolved_on_other_thread);
+
+    doTestCallingJavaLazily();
+    
+    std::thread yetAnotherThread(doTestCallingJavaLazily);
+    
+    yetAnotherThread.join();
+}
+
+TEST_CASE( "testInlineAccessors", "[integration]" )
+{
+    JNIEnv * env = jni_provider::get_jni();
+
+    //free functions need no class table lookup
+    auto inlined = Inlined_inline::ctor(env, 21);
+    CHECK(42 == Inlined_inline::twice(env, inlined));
+    Inlined_inline::set_value(env, inlined, 5);
+    CHECK(5 == Inlined_inline::get_value(env, inlined));
+    CHECK(7 == Inlined_inline::get_staticValue(env));
+    CHECK(java_string_to_cpp(env, Inlined_inline::describe(env, 3)) == "value 3");
+
+    //the class forwards to them
+    auto & inlined_class = java_classes::get<Inlined>();
+    CHECK(5 == inlined_class.get_value(env, inlined));
+    CHECK(10 == inlined_class.twice(env, inlined));
+
+    //lazy tables still construct classes with inline accessors in init()
+    typedef java_class_table<Inlined> lazy_classes;
+    lazy_classes::init(env, java_class_table_mode::lazy);
+    CHECK(lazy_classes::init_timings()[0].constructed);
+    lazy_classes::term();
+}
+
+TEST_CASE( "testClassTableTimings", "[integration]" )
+{
+    auto timings = java_classes::init_timings();
+    CHECK(timings.size() == std::tuple_size_v<java_classes::transformed_type<std::add_pointer_t>>);
+    for (auto & timing: timings)
+    {
+        INFO(timing.name);
+        CHECK(timing.constructed);
+        CHECK(timing.name[0] != '\0');
+        CHECK(timing.duration.count() >= 0);
+    }
+}
+
+TEST_CASE( "testThreadPool", "[integration]" )
+{
+    JNIEnv * env = jni_provider::get_jni();
+    size_t attached = jni_provider::attached_threads();
+    {
+        java_thread_pool pool(2, "smjni-test");
+        CHECK(pool.size() == 2);
+        CHECK(jni_provider::attached_threads() == attached + 2);
+
+        auto str = pool.submit([] (JNIEnv * env) {
+            return java_string_create(env, "abc");
+        });
+        auto number = pool.submit([] (JNIEnv * env) {
+            return java_classes::get<Base>().staticMethod(env, 17);
+        });
+        auto failure = pool.submit([] (JNIEnv * env) {
+            THROW_JAVA_PROBLEM("expected");
+        });
+
+        CHECK(java_string_to_cpp(env, str.get()) == "abc");
+        CHECK(number.get() == 17);
+        CHECK_THROWS_AS(failure.get(), std::runtime_error);
+    }
+    //workers are detached when they exit
+    CHECK(jni_provider::attached_threads() == attached);
+}
+
+
+TEST_CASE( "testGlobalRefPool", "[integration]" )
+{
+    JNIEnv * env = jni_provider::get_jni();
+    auto str = java_string_create(env, "abc");
+
+    auto before = global_ref_pool::get_statistics();
+    {
+        global_java_ref<jstring> ref(str);
+    }
+    auto after = global_ref_pool::get_statistics();
+    CHECK(after.created == before.created + 1);
+    CHECK(after.deleted == before.deleted + 1);
+
+    CHECK(after.live == before.live);
+
+    //references are deleted right away on any thread
+    {
+        global_java_ref<jstring> shared(str);
+        std::thread([&shared] () {
+            global_java_ref<jstring> ref1(shared), ref2(shared);
+        }).join();
+    }
+    auto threaded = global_ref_pool::get_statistics();
+    CHECK(threaded.created == after.created + 3);
+    CHECK(threaded.deleted == after.deleted + 3);
+}
+
+TEST_CASE( "testLocalRefBudget", "[integration]" )
+{
+    JNIEnv * env = jni_provider::get_jni();
+    java_frame frame(env, 4);
+    auto start = local_ref_budget::live();
+    {
+        ensure_local_capacity capacity(env, 300);
+        auto_frame_loop loop(env, 10, 2);
+        for (int i = 0; i < 100; ++i)
+        {
+            loop.next();
+            auto str = java_string_create(env, "abc");
+            auto copy = str;
+            if (local_ref_budget::enabled)
+                CHECK(local_ref_budget::live() <= start + 2);
+        }
+        if (local_ref_budget::enabled)
+            CHECK(local_ref_budget::high_water_mark() == start + 2);
+    }
+    CHECK(local_ref_budget::live() == start);
+
+    {
+        //released references are no longer ours to count
+        auto str = java_string_create(env, "abc");
+        jstring raw = str.release();
+        CHECK(local_ref_budget::live() == start);
+        env->DeleteLocalRef(raw);
+    }
+    {
+        local_ref_budget::native_scope scope;
+        //stands for a reference left for the VM to free when the native method returns
+        local_ref_budget::on_created();
+    }
+    CHECK(local_ref_budget::live() == start);
+}
+
+TEST_CASE( "testWeakObjectCache", "[integration]" )
+{
+    JNIEnv * env = jni_provider::get_jni();
+    auto str = java_string_create(env, "abc");
+
+    weak_object_cache<int> cache;
+    cache.put(env, 1, str);
+    CHECK(cache.size() == 1);
+
+    auto found = cache.get<jstring>(env, 1);
+    REQUIRE(found);
+    CHECK(env->IsSameObject(found.c_ptr(), str.c_ptr()));
+    CHECK_FALSE(cache.get(env, 2));
+
+    auto stats = cache.get_statistics();
+    CHECK(stats.hits == 1);
+    CHECK(stats.misses == 1);
+    CHECK(stats.dead == 0);
+
+    CHECK(cache.erase(1));
+    CHECK_FALSE(cache.erase(1));
+    CHECK(cache.size() == 0);
+}
+
+struct PeerObject
+{
+    int value;
+};
+
+TEST_CASE( "testNativePeer", "[integration]" )
+{
+    JNIEnv * env = jni_provider::get_jni();
+    auto & peered_class = java_classes::get<Peered>();
+    auto obj = peered_class.ctor(env);
+
+    CHECK_THROWS_AS(peered_class.get_peer(env, obj), std::runtime_error);
+
+    PeerObject peer{42};
+    CHECK(peered_class.attach_peer(env, obj, &peer) == nullptr);
+    CHECK(&peered_class.get_peer(env, obj) == &peer);
+    CHECK(peered_class.get_peer(env, obj).value == 42);
+
+    //attaching over a peer hands the old one back
+    PeerObject replacement{7};
+    CHECK(peered_class.attach_peer(env, obj, &replacement) == &peer);
+    CHECK(peered_class.get_peer(env, obj).value == 7);
+
+    CHECK(peered_class.detach_peer(env, obj) == &replacement);
+    CHECK_THROWS_AS(peered_class.get_peer(env, obj), std::runtime_error);
+    CHECK(peered_class.detach_peer(env, obj) == nullptr);
+}
+
+TEST_CASE( "testJavaExceptionWhat", "[integration]" )
+{
+    JNIEnv * env = jni_provider::get_jni();
+
+    java_exception short_ex(java_runtime::throwable().ctor(env, java_string_create(env, "boom")));
+    CHECK(std::string(short_ex.what()) == "smjni::java_exception: java.lang.Throwable: boom");
+
+    std::string long_message(1000, 'x');
+    java_exception long_ex(java_runtime::throwable().ctor(env, java_string_create(env, long_message)));
+    std::string what = long_ex.what();
+    CHECK(what.find("smjni::java_exception: java.lang.Throwable: xxx") == 0);
+    CHECK(what.size() < 256);
+}
+
+class test_base_error : public java_exception
+{
+public:
+    using java_exception::java_exception;
+};
+
+class test_derived_error : public test_base_error
+{
+public:
+    using test_base_error::test_base_error;
+};
+
+TEST_CASE( "testExceptionDispatcher", "[integration]" )
+{
+    JNIEnv * env = jni_provider::get_jni();
+    auto & test_class = java_classes::get<TestSmJNI>();
+
+    //registration order must not matter, the most derived class wins either way
+    java_exception_dispatcher base_first;
+    base_first.add<test_base_error>(java_classes::get<TestBaseException>());
+    base_first.add<test_derived_error>(java_classes::get<TestDerivedException>());
+    java_exception_dispatcher derived_first;
+    derived_first.add<test_derived_error>(java_classes::get<TestDerivedException>());
+    derived_first.add<test_base_error>(java_classes::get<TestBaseException>());
+
+    for (auto dispatcher: {&base_first, &derived_first})
+    {
+        java_exception_dispatcher::scoped_install installed(*dispatcher);
+
+        CHECK_THROWS_AS(test_class.throwException(env, true), test_derived_error);
+        try
+        {
+            test_class.throwException(env, false);
+            FAIL("no exception");
+        }
+        catch(test_derived_error &)
+        {
+            FAIL("wrong exception type");
+        }
+        catch(test_base_error &)
+        {
+        }
+    }
+
+    try
+    {
+        test_class.throwException(env, true);
+        FAIL("no exception");
+    }
+    catch(test_base_error &)
+    {
+        FAIL("dispatcher still installed");
+    }
+    catch(java_exception &)
+    {
+    }
+}
+
+static std::string translated_description(JNIEnv * env, const std::exception & ex)
+{
+    java_exception::translate(env, ex);
+    auto pending = jattach(env, env->ExceptionOccurred());
+    env->ExceptionClear();
+    REQUIRE(pending);
+    return java_exception(pending).what();
+}
+
+TEST_CASE( "testExceptionTranslator", "[integration]" )
+{
+    JNIEnv * env = jni_provider::get_jni();
+
+    java_exception_translator::add<std::out_of_range>(env, java_classes::get<TestBaseException>(), "fixed");
+    java_exception_translator::add<std::logic_error>(env, java_classes::get<TestBaseException>());
+
+    CHECK(translated_description(env, std::invalid_argument("bad")) ==
+          "smjni::java_exception: smjni.tests.TestSmJNI$TestBaseException: bad");
+    CHECK(translated_description(env, std::out_of_range("ignored")) ==
+          "smjni::java_exception: smjni.tests.TestSmJNI$TestBaseException: fixed");
+    CHECK(translated_description(env, std::runtime_error("plain")) ==
+          "smjni::java_exception: java.lang.Throwable: plain");
+    CHECK(translated_description(env, std::runtime_error("baby 👶")) ==
+          "smjni::java_exception: java.lang.Throwable: baby 👶");
+    //Malformed UTF-8 must not reach ThrowNew
+    CHECK(translated_description(env, std::runtime_error("caf\xE9!")) ==
+          "smjni::java_exception: java.lang.Throwable: caf\uFFFD!");
+    CHECK(translated_description(env, std::runtime_error("\xED\xA0\x80")) ==
+          "smjni::java_exception: java.lang.Throwable: \uFFFD\uFFFD\uFFFD");
+
+    java_exception::translate(env, std::bad_alloc());
+    auto pending = jattach(env, env->ExceptionOccurred());
+    env->ExceptionClear();
+    CHECK(env->IsSameObject(pending.c_ptr(), java_runtime::out_of_memory_error().c_ptr()));
+
+    java_exception::translate(env, native_stack_overflow());
+    pending = jattach(env, env->ExceptionOccurred());
+    env->ExceptionClear();
+    CHECK(env->IsSameObject(pending.c_ptr(), java_runtime::stack_overflow_error().c_ptr()));
+
+    java_exception_translator::clear();
+}
+
+TEST_CASE( "testNativeBacktrace", "[integration]" )
+{
+    JNIEnv * env = jni_provider::get_jni();
+
+    CHECK_FALSE(native_backtrace::capture());
+    try
+    {
+        THROW_JAVA_PROBLEM("untraced");
+    }
+    catch(std::exception & ex)
+    {
+        CHECK_FALSE(native_backtrace::of(ex));
+    }
+
+    native_backtrace::set_enabled(true);
+    try
+    {
+        THROW_JAVA_PROBLEM("traced");
+    }
+    catch(std::exception & ex)
+    {
+        auto backtrace = native_backtrace::of(ex);
+        REQUIRE(backtrace);
+        CHECK(backtrace->size() > 0);
+        auto frames = backtrace->symbolize_async().get();
+        CHECK(frames.size() == backtrace->size());
+
+        java_exception::translate(env, ex);
+    }
+    native_backtrace::set_enabled(false);
+
+    auto pending = jattach(env, env->ExceptionOccurred());
+    env->ExceptionClear();
+    REQUIRE(pending);
+
+    jclass throwable_class = java_runtime::throwable().c_ptr();
+    jmethodID get_trace = env->GetMethodID(throwable_class, "getStackTrace", "()[Ljava/lang/StackTraceElement;");
+    auto trace = jattach(env, static_cast<jobjectArray>(env->CallObjectMethod(pending.c_ptr(), get_trace)));
+    REQUIRE(trace);
+    REQUIRE(env->GetArrayLength(trace.c_ptr()) > 0);
+    auto first = jattach(env, env->GetObjectArrayElement(trace.c_ptr(), 0));
+    jclass element_class = env->GetObjectClass(first.c_ptr());
+    jmethodID is_native = env->GetMethodID(element_class, "isNativeMethod", "()Z");
+    CHECK(env->CallBooleanMethod(first.c_ptr(), is_native));
+    env->DeleteLocalRef(element_class);
+}
+
+static std::atomic<int> g_logged_count{0};
+static std::atomic<int> g_logged_dropped{0};
+
+static void counting_log_sink(const char * message) noexcept
+{
+    if (strstr(message, "dropped"))
+        ++g_logged_dropped;
+    else
+        ++g_logged_count;
+}
+
+TEST_CASE( "testLogging", "[integration]" )
+{
+    set_externals(nullptr, nullptr, counting_log_sink);
+    int logged = g_logged_count;
+    int dropped = g_logged_dropped;
+
+    //asynchronous by default
+    internal::do_log_error(std::runtime_error("first"), "with %s", "details");
+    flush_log();
+    CHECK(g_logged_count == logged + 1);
+
+    set_log_async(false);
+
+    set_log_rate_limit(5);
+    for (int i = 0; i < 20; ++i)
+        internal::do_log_error(std::runtime_error("storm"), nullptr);
+    CHECK(g_logged_count <= logged + 7);
+    set_log_rate_limit(0);
+
+    //drops are reported no later than with the next record
+    internal::do_log_error(std::runtime_error("after storm"), nullptr);
+    CHECK(g_logged_dropped > dropped);
+
+    set_log_async(true);
+    
+    set_externals(nullptr, nullptr, nullptr);
+}
+
+TEST_CASE( "testCallStats", "[integration]" )
+{
+    JNIEnv * env = jni_provider::get_jni();
+    auto & peered_class = java_classes::get<Peered>();
+
+    java_call_stats::reset();
+    java_call_stats::set_enabled(true);
+    for (int i = 0; i < 10; ++i)
+        peered_class.ctor(env);
+    java_call_stats::set_enabled(false);
+    peered_class.ctor(env);
+
+    std::string json = java_call_stats::snapshot_json();
+    CHECK(json.find("{\"kind\":\"constructor\",\"class\":\"smjni.tests.TestSmJNI$Peered\",\"name\":\"<init>\",\"signature\":\"()V\",\"count\":10,") != std::string::npos);
+
+    typedef internal::java_call_site site;
+    for (unsigned i = 0; i < site::bucket_count; ++i)
+        CHECK(site::bucket_of(site::bucket_low(i)) == i);
+}
+
+TEST_CASE( "testVmHostOptions", "[integration]" )
+{
+    java_vm_options options;
+    options.class_path = {"a.jar", "b.jar"};
+    options.initial_heap = 64 << 20;
+    options.max_heap = size_t(2) << 30;
+    options.gc = java_gc::g1;
+    options.check_jni = true;
+    options.cds = java_cds_mode::automatic;
+    options.shared_archive = "app.jsa";
+    options.extra = {"-Dsmjni.test=1"};
+
+    auto strings = options.to_vm_options();
+    REQUIRE(strings.size() == 8);
+    CHECK(strings[0].rfind("-Djava.class.path=a.jar", 0) == 0);
+    CHECK(strings[1] == "-Xms64m");
+    CHECK(strings[2] == "-Xmx2g");
+    CHECK(strings[3] == "-XX:+UseG1GC");
+    CHECK(strings[4] == "-Xcheck:jni");
+    CHECK(strings[5] == "-Xshare:auto");
+    CHECK(strings[6] == "-XX:SharedArchiveFile=app.jsa");
+    CHECK(strings[7] == "-Dsmjni.test=1");
+
+    //we are running inside a VM already
+    CHECK_THROWS_AS(java_vm_host(options), std::runtime_error);
+}
+
+TEST_CASE( "testJavaCompletion", "[integration]" )
+{
+    JNIEnv * env = jni_provider::get_jni();
+    auto & test_class = java_classes::get<TestSmJNI>();
+
+    class recorder final : public java_completion_callback
+    {
+    public:
+        recorder(std::promise<std::string> & outcome): m_outcome(outcome)
+        {}
+
+        void on_complete(JNIEnv * env, jobject result, jthrowable error) noexcept override
+        {
+            if (error)
+                m_outcome.set_value("error");
+            else
+                m_outcome.set_value(java_string_to_cpp(env, jauto(jstatic_cast<jstring>(result))));
+        }
+    private:
+        std::promise<std::string> & m_outcome;
+    };
+
+    auto listen = [env] (const auto & future) {
+        std::promise<std::string> outcome;
+        auto ret = outcome.get_future();
+        java_completion::listen(env, jauto(jstatic_cast<jCompletableFuture>(future.c_ptr())),
+                                std::make_unique<recorder>(outcome));
+        return ret.get();
+    };
+
+    CHECK(listen(test_class.completedFuture(env, java_string_create(env, "now"))) == "now");
+    CHECK(listen(test_class.asyncFuture(env, java_string_create(env, "later"))) == "later");
+    CHECK(listen(test_class.failedFuture(env, java_string_create(env, "oops"))) == "error");
+}
+
+TEST_CASE( "testEventBatcher", "[integration]" )
+{
+    JNIEnv * env = jni_provider::get_jni();
+    auto & test_class = java_classes::get<TestSmJNI>();
+
+    struct event
+    {
+        jint id;
+        jint value;
+    };
+    auto sink = [&test_class] (JNIEnv * env, const auto_java_ref<jByteBuffer> & buffer, jint count) {
+        test_class.onEvents(env, buffer, count);
+    };
+
+    java_event_batcher_policy policy;
+    policy.batch_size = 64;
+    policy.batch_count = 2;
+    policy.max_delay = std::chrono::hours(1);
+    {
+        java_event_batcher<event, decltype(sink)> batcher(sink, policy);
+        jlong expected = 0;
+        for (jint i = 0; i < 1000; ++i)
+        {
+            batcher.push({i, 2 * i});
+            expected += 2 * i;
+        }
+        batcher.flush();
+        CHECK(test_class.takeEventSum(env) == expected);
+        //15 full batches and the partial one forced out by flush
+        CHECK(test_class.takeEventBatches(env) == 16);
+    }
+
+    policy.max_delay = std::chrono::milliseconds(1);
+    {
+        java_event_batcher<event, decltype(sink)> batcher(sink, policy);
+        batcher.push({0, 42});
+        jlong sum = 0;
+        for (int i = 0; i < 1000 && sum == 0; ++i)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            sum = test_class.takeEventSum(env);
+        }
+        CHECK(sum == 42);
+        CHECK(test_class.takeEventBatches(env) == 1);
+    }
+}
+
+TEST_CASE( "testCompileTimeSignatures", "[integration]" )
+{
+    //these are constexpr so any of them requiring dynamic initialization fails the build
+    static_assert(internal::java_field_signature_v<jint> == "I");
+    static_assert(internal::java_field_signature_v<jobjectArray> == "[Ljava/lang/Object;");
+    static_assert(internal::java_method_signature_v<void> == "()V");
+    static_assert(internal::java_method_signature_v<jstring, jint, jobject> == "(ILjava/lang/Object;)Ljava/lang/String;");
+    static_assert(internal::java_class_path_v<jthrowable> == "java/lang/Throwable");
+
+    constexpr const char * sig = internal::java_method_signature<jboolean, jlong>();
+    CHECK(strcmp(sig, "(J)Z") == 0);
+    CHECK(sig == internal::java_method_signature<jboolean, jlong>());
+}
+
+TEST_CASE( "testRegisterAllNatives", "[integration]" )
+{
+    JNIEnv * env = jni_provider::get_jni();
+
+    //registering again is allowed and the class reference is already loaded
+    auto timings = register_all_natives<TestSmJNI>(env);
+    REQUIRE(timings.size() == 1);
+    CHECK(strcmp(timings[0].name, "smjni.tests.TestSmJNI") == 0);
+    CHECK(timings[0].method_count == jint(std::size(TestSmJNI::native_methods)));
+    CHECK(timings[0].registration.count() > 0);
+
+    CHECK(java_classes::get<TestSmJNI>().testCallingNativeMethod(env) == java_true);
+}
+
+TEST_CASE( "testCriticalNative", "[integration]" )
+{
+    JNIEnv * env = jni_provider::get_jni();
+
+    CHECK(java_classes::get<TestSmJNI>().callCriticalHash(env, 5, 7) == 5 * 31 + 7);
+}
+
+//no JNIEnv, jclass or NATIVE_PROLOG: critical natives must not touch Java or throw
+jint JNICALL TestSmJNI::criticalHash(jint value, jlong seed)
+{
+    return jint(value * 31 + seed);
+}
+
+TEST_CASE( "testFieldSnapshot", "[integration]" )
+{
+    JNIEnv * env = jni_provider::get_jni();
+
+    auto & snapshotted_class = java_classes::get<Snapshotted>();
+    auto obj = snapshotted_class.ctor(env);
+    Snapshotted::snapshot_buffer buffer(env);
+
+    Snapshotted::snapshot value = { 0, JNI_TRUE, u'x', -5000000000LL, -0.0f, 3.25 };
+    snapshotted_class.set_snapshot(env, obj, buffer, value);
+    CHECK(snapshotted_class.get_visible(env, obj) == JNI_TRUE);
+    CHECK(snapshotted_class.get_size(env, obj) == -5000000000LL);
+    CHECK(snapshotted_class.get_weight(env, obj) == 3.25);
+
+    auto read = snapshotted_class.get_snapshot(env, obj, buffer);
+    //final fields are not written back
+    CHECK(read.id == 42);
+    CHECK(read.visible == JNI_TRUE);
+    CHECK(read.letter == u'x');
+    CHECK(read.size == -5000000000LL);
+    CHECK(std::signbit(read.scale));
+    CHECK(read.weight == 3.25);
+}
 
 TEST_CASE( "testPrimitiveArray", "[integration]" )
 {
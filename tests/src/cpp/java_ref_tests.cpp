@@ -112,3 +112,33 @@ TEST_CASE( "testJavaRefProperties", "[javaref]" )
 
     });
 }
+
+TEST_CASE( "testJavaClassProperties", "[javaref]" )
+{
+    CHECK(std::is_trivially_copyable_v<java_class<jobject>>);
+    CHECK(std::is_nothrow_copy_constructible_v<java_class<jobject>>);
+    CHECK(sizeof(java_class<jobject>) == sizeof(jclass));
+}
+
+TEST_CASE( "testUniqueLocalRefProperties", "[javaref]" )
+{
+    using T = unique_local_ref<jstring>;
+
+    CHECK(std::is_nothrow_default_constructible_v<T>);
+    CHECK((std::is_nothrow_constructible_v<T, std::nullptr_t>));
+    CHECK_FALSE(std::is_copy_constructible_v<T>);
+    CHECK_FALSE(std::is_copy_assignable_v<T>);
+    CHECK(std::is_nothrow_move_constructible_v<T>);
+    CHECK(std::is_nothrow_move_assignable_v<T>);
+    CHECK(sizeof(T) == sizeof(local_java_ref<jstring>));
+
+    CHECK((std::is_nothrow_constructible_v<local_java_ref<jstring>, T &&>));
+    CHECK((std::is_nothrow_constructible_v<unique_local_ref<jobject>, T &&>));
+    CHECK((std::is_nothrow_constructible_v<auto_java_ref<jobject>, const T &>));
+    CHECK((std::is_convertible_v<const T &, const local_java_ref<jstring> &>));
+    CHECK_FALSE((std::is_constructible_v<local_java_ref<jstring>, const T &>));
+    CHECK_FALSE((std::is_assignable_v<local_java_ref<jstring> &, const T &>));
+    CHECK((std::is_nothrow_assignable_v<local_java_ref<jobject> &, T &&>));
+    CHECK((std::is_same_v<decltype(std::declval<const T &>().share()), local_java_ref<jstring>>));
+    CHECK((std::is_same_v<java_type_traits<jstring>::return_type, T>));
+}
@@ -39,7 +39,9 @@ JNIEXPORT jint JNI_OnLoad(JavaVM *vm, void *reserved)
         java_runtime::init(env);
 
         NATIVE_PROLOG
+            register_all_natives<JNIGEN_ALL_NATIVE_CLASSES>(env);
             java_classes::init(env);
+            java_completion::init(env);
 
             return JNI_VERSION_1_6;
         NATIVE_EPILOG
@@ -1,6 +1,9 @@
 #ifndef HEADER_TEST_UTIL_H
 #define HEADER_TEST_UTIL_H
 
+//C++ side of TestSmJNI.Peered
+struct PeerObject;
+
 #include "generated/all_classes.h"
 
 #define CONCAT_TOKEN(foo, bar) CONCAT_TOKEN_IMPL(foo, bar)
@@ -8,7 +11,8 @@
 #define STRINGIFY(name) STRINGIFY_IMPL(name)
 #define STRINGIFY_IMPL(name) #name
 
-#define NATIVE_PROLOG  try {
+#define NATIVE_PROLOG  try { \
+                           smjni::local_ref_budget::native_scope native_local_ref_scope;
 #define NATIVE_EPILOG  } \
                        catch(java_exception & ex) \
                        { \
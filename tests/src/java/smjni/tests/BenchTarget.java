@@ -0,0 +1,43 @@
+/*
+ Copyright 2019 SmJNI Contributors
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+package smjni.tests;
+
+//Callee for smjnibench. Deliberately not exposed via jnigen: the benchmark
+//declares its own wrapper so that it does not depend on the test natives
+class BenchTarget {
+
+    BenchTarget() {
+    }
+
+    int call0() { return value; }
+    int call1(int a1) { return a1; }
+    int call2(int a1, int a2) { return a2; }
+    int call3(int a1, int a2, int a3) { return a3; }
+    int call4(int a1, int a2, int a3, int a4) { return a4; }
+    int call5(int a1, int a2, int a3, int a4, int a5) { return a5; }
+    int call6(int a1, int a2, int a3, int a4, int a5, int a6) { return a6; }
+    int call7(int a1, int a2, int a3, int a4, int a5, int a6, int a7) { return a7; }
+    int call8(int a1, int a2, int a3, int a4, int a5, int a6, int a7, int a8) { return a8; }
+
+    BenchTarget self() { return this; }
+
+    static int staticCall0() { return 0; }
+
+    int value;
+    long size;
+    double weight;
+}
@@ -0,0 +1,37 @@
+/*
+ Copyright 2019 SmJNI Contributors
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+package smjni.tests;
+
+//Mirrors the helper jnigen generates for @ExposeToNative(snapshot = true) on BenchTarget
+final class BenchTargetSnapshot {
+
+    private BenchTargetSnapshot() {}
+
+    static void read(BenchTarget obj, java.nio.ByteBuffer slots) {
+        slots.order(java.nio.ByteOrder.nativeOrder());
+        slots.putLong(0, obj.value);
+        slots.putLong(8, obj.size);
+        slots.putLong(16, Double.doubleToRawLongBits(obj.weight));
+    }
+
+    static void write(BenchTarget obj, java.nio.ByteBuffer slots) {
+        slots.order(java.nio.ByteOrder.nativeOrder());
+        obj.value = (int)slots.getLong(0);
+        obj.size = slots.getLong(8);
+        obj.weight = Double.longBitsToDouble(slots.getLong(16));
+    }
+}
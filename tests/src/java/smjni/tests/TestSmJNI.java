@@ -20,6 +20,8 @@ import smjni.jnigen.CalledByNative;
 import smjni.jnigen.ExposeToNative;
 
 import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.util.concurrent.CompletableFuture;
 
 import static org.junit.jupiter.api.Assertions.*;
 
@@ -69,6 +71,187 @@ class TestSmJNI  {
         }
     }
 
+    @ExposeToNative(typeName="jLazy", className="Lazy", lazy=true)
+    static class Lazy
+    {
+        @CalledByNative
+        Lazy(int val)
+        {
+            value = val;
+        }
+
+        @CalledByNative
+        static int staticMethod(int val)
+        {
+            return val;
+        }
+
+        @CalledByNative
+        int instanceMethod(int val)
+        {
+            return val + 1;
+        }
+
+        @CalledByNative
+        int value;
+        @CalledByNative
+        static int staticValue = 15;
+    }
+
+    @ExposeToNative(typeName="jInlined", className="Inlined", inlineAccessors=true)
+    static class Inlined
+    {
+        @CalledByNative
+        Inlined(int val)
+        {
+            value = val;
+        }
+
+        @CalledByNative
+        static String describe(int val)
+        {
+            return "value " + val;
+        }
+
+        @CalledByNative
+        int twice()
+        {
+            return value * 2;
+        }
+
+        @CalledByNative
+        int value;
+        @CalledByNative
+        static int staticValue = 7;
+    }
+
+    @ExposeToNative(typeName="jPeered", className="Peered")
+    static class Peered
+    {
+        @CalledByNative
+        Peered()
+        {
+        }
+
+        @CalledByNative(nativePeer="PeerObject")
+        long peer;
+    }
+
+    @ExposeToNative(typeName="jSnapshotted", className="Snapshotted", snapshot=true)
+    static class Snapshotted
+    {
+        @CalledByNative
+        Snapshotted()
+        {
+        }
+
+        @CalledByNative
+        final int id = 42;
+        @CalledByNative
+        boolean visible;
+        @CalledByNative
+        char letter;
+        @CalledByNative
+        long size;
+        @CalledByNative
+        float scale;
+        @CalledByNative
+        double weight;
+    }
+
+    @ExposeToNative(typeName="jTestBaseException", className="TestBaseException")
+    static class TestBaseException extends RuntimeException
+    {
+        @CalledByNative
+        TestBaseException()
+        {
+        }
+
+        TestBaseException(String message)
+        {
+            super(message);
+        }
+    }
+
+    @ExposeToNative(typeName="jTestDerivedException", className="TestDerivedException")
+    static class TestDerivedException extends TestBaseException
+    {
+        @CalledByNative
+        TestDerivedException()
+        {
+        }
+    }
+
+    @CalledByNative
+    private static void throwException(boolean derived)
+    {
+        if (derived)
+            throw new TestDerivedException();
+        throw new TestBaseException();
+    }
+
+    @CalledByNative
+    private static CompletableFuture<String> completedFuture(String value)
+    {
+        return CompletableFuture.completedFuture(value);
+    }
+
+    @CalledByNative
+    private static CompletableFuture<String> asyncFuture(String value)
+    {
+        return CompletableFuture.supplyAsync(() -> value);
+    }
+
+    @CalledByNative
+    private static CompletableFuture<String> failedFuture(String message)
+    {
+        CompletableFuture<String> ret = new CompletableFuture<>();
+        ret.completeExceptionally(new IllegalStateException(message));
+        return ret;
+    }
+
+    //Updated on the batcher thread and read on the test thread, both under the class lock
+    //so that the sum and the batch count are always seen together
+    private static long eventSum;
+    private static int eventBatches;
+
+    @CalledByNative
+    private static synchronized void onEvents(ByteBuffer buffer, int count)
+    {
+        //native struct { jint id; jint value; }
+        buffer.order(ByteOrder.nativeOrder());
+        long sum = 0;
+        for (int i = 0; i < count; ++i)
+            sum += buffer.getInt(i * 8 + 4);
+        eventSum += sum;
+        ++eventBatches;
+    }
+
+    @CalledByNative
+    private static synchronized long takeEventSum()
+    {
+        long ret = eventSum;
+        eventSum = 0;
+        return ret;
+    }
+
+    @CalledByNative
+    private static synchronized int takeEventBatches()
+    {
+        int ret = eventBatches;
+        eventBatches = 0;
+        return ret;
+    }
+
+    @CriticalNative
+    private static native int criticalHash(int value, long seed);
+
+    @CalledByNative
+    private static int callCriticalHash(int value, long seed)
+    {
+        return criticalHash(value, seed);
+    }
+
     public static void main(String[] args) {
         System.loadLibrary("smjnitests");
         testMain(args);